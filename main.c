@@ -7,58 +7,95 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
 #include <ctype.h>
 #include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <pthread.h>
 
-// Stack Data Structure
-typedef struct node {
-    int32_t data;
-    struct node *next;
-} node_t;
+// Marks functions only the interpreter's own main uses, so that programs
+// built from --emit-c output, which define PSI_NO_MAIN, compile without
+// unused-function warnings.
+#define MAIN_ONLY __attribute__((unused))
 
-typedef struct Stack {
-    node_t *head;
-} Stack;
+// Generators switch stacks with a few lines of assembly on x86-64 and arm64,
+// and with ucontext elsewhere or when PSI_UCONTEXT_COROUTINES is defined.
+#if defined(PSI_UCONTEXT_COROUTINES) || !(defined(__x86_64__) || defined(__aarch64__))
+#define COROUTINE_USE_UCONTEXT 1
+#include <ucontext.h>
+#endif
 
-static int32_t stack_is_empty(Stack *stack) {
-    return stack->head == NULL;
-}
+// The parser scans its input sixteen bytes at a time with SSE2 or NEON when
+// the target has them, and one byte at a time otherwise.
+#if defined(__SSE2__) && !defined(PSI_SCALAR_SCAN)
+#define STRUCTURAL_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON) && !defined(PSI_SCALAR_SCAN)
+#define STRUCTURAL_NEON 1
+#include <arm_neon.h>
+#endif
 
-static int32_t stack_init(Stack *stack) {
-    stack->head = NULL;
-    return 0;
+// Work Stack
+// Tree traversals keep their pending work on this explicit stack instead of
+// recursing on the C stack, so nesting depth is bounded only by memory. The
+// first entries live inside the struct, in the caller's frame; deeper stacks
+// move to a heap buffer that doubles as it fills. Pointers returned by
+// work_stack_push and work_stack_top are valid until the next push.
+#define WORK_STACK_INLINE_BYTES 512
+
+typedef struct work_stack {
+    char *items;
+    size_t item_size;
+    int32_t count;
+    int32_t capacity;
+    char inline_items[WORK_STACK_INLINE_BYTES];
+} work_stack_t;
+
+static void work_stack_init(work_stack_t *stack, size_t item_size) {
+    stack->items = stack->inline_items;
+    stack->item_size = item_size;
+    stack->count = 0;
+    stack->capacity = (int32_t)(WORK_STACK_INLINE_BYTES / item_size);
 }
 
-static int32_t stack_insert(Stack *stack, int32_t value) {
-    node_t *new_node = malloc(sizeof(node_t));
-    if (new_node == NULL) {
-        return -1;
+static void *work_stack_push(work_stack_t *stack) {
+    if (stack->count == stack->capacity) {
+        if (stack->capacity > INT32_MAX / 2) {
+            return NULL;
+        }
+        size_t new_capacity = (size_t)stack->capacity * 2;
+        char *grown = stack->items == stack->inline_items
+            ? malloc(new_capacity * stack->item_size)
+            : realloc(stack->items, new_capacity * stack->item_size);
+        if (grown == NULL) {
+            return NULL;
+        }
+        if (stack->items == stack->inline_items) {
+            memcpy(grown, stack->inline_items, stack->count * stack->item_size);
+        }
+        stack->items = grown;
+        stack->capacity = (int32_t)new_capacity;
     }
-    new_node->data = value;
-    new_node->next = stack->head;
-    stack->head = new_node;
-    return 0;
+    return stack->items + (size_t)stack->count++ * stack->item_size;
 }
 
-static int32_t stack_pop(Stack *stack) {
-    if (stack_is_empty(stack)) {
-        return -1;
-    }
-    node_t *temp_node = stack->head;
-    int32_t popped_value = temp_node->data;
-    stack->head = stack->head->next;
-    free(temp_node);
-    return popped_value;
+static void *work_stack_top(work_stack_t *stack) {
+    return stack->items + (size_t)(stack->count - 1) * stack->item_size;
 }
 
-static void clear_stack(Stack *stack) {
-    while (stack->head != NULL) {
-        node_t *current_node = stack->head;
-        stack->head = stack->head->next;
-        free(current_node);
+static void work_stack_free(work_stack_t *stack) {
+    if (stack->items != stack->inline_items) {
+        free(stack->items);
     }
+    stack->items = stack->inline_items;
+    stack->count = 0;
 }
 
 // PSI Value System
@@ -68,37 +105,297 @@ typedef enum {
     PVAL_SYMBOL,
     PVAL_LIST,
     PVAL_FUNCTION,
+    PVAL_CLOSURE,
+    PVAL_PROMISE,
+    PVAL_GENERATOR,
+    PVAL_VALUES,
+    PVAL_BYTES,
     PVAL_ERROR
 } pval_t;
 
 struct pval;
+struct lambda_code;
+struct memo_table;
+struct promise;
+struct generator;
+struct byte_string;
 typedef struct pval *(*builtin_function_ptr)(struct pval **args, int32_t arg_count);
 
+// Only the fields of the value's type are valid.
 typedef struct pval {
     pval_t type;
-    double number;
-    bool boolean;
-    char *symbol;
-    struct pval **list_items;
-    int32_t list_count;
-    int32_t list_capacity;
-    builtin_function_ptr function;
-    char *error_type;
-    char *error_message;
+    bool hash_consed; // Lives in a cons_node_t; see Hash-Consing
+    union {
+        double number;
+        bool boolean;
+        struct {
+            char *symbol;
+            int32_t frame_slot; // Frame Lookup
+        };
+        struct {
+            struct pval **list_items;
+            int32_t list_count;
+            int32_t list_capacity;
+            struct call_site *site;
+        };
+        builtin_function_ptr function;
+        struct {
+            char *error_type;
+            char *error_message;
+        };
+        struct {
+            struct lambda_code *code;
+            struct pval **captures;
+            struct memo_table *memo;
+        };
+        struct promise *promise;
+        struct generator *generator;
+        struct byte_string *bytes;
+    };
 } pval;
 
+// Caches of a list evaluated as code, made the first time one is needed, so
+// a list used only as data carries just the pointer to them.
+typedef struct call_site {
+    struct lambda_code *code; // Compiled lambda, delay or receive body
+    pval *expansion; // Macros
+    int32_t expansion_generation;
+    int32_t site_kind; // Superinstructions
+    builtin_function_ptr site_builtin;
+    bool trace_failed; // Numeric Trace
+} call_site_t;
+
+// Compiled lambda, shared by every closure made from the same expression.
+// names holds the parameters followed by the captured free variables, which
+// is also the layout of the frame a call evaluates the body in. The
+// captures were found in the macro expansions of macro_generation.
+typedef struct lambda_code {
+    int32_t ref_count;
+    char **names;
+    int32_t param_count;
+    int32_t capture_count;
+    pval *body;
+    int32_t macro_generation;
+} lambda_code_t;
+
+// Memo table of a memoized closure; see Memoization.
+typedef struct memo_entry {
+    uint64_t hash;
+    pval **args;
+    int32_t arg_count;
+    pval *result;
+    struct memo_entry *bucket_next;
+    struct memo_entry *newer;
+    struct memo_entry *older;
+} memo_entry_t;
+
+typedef struct memo_table {
+    int32_t ref_count;
+    memo_entry_t **buckets;
+    int32_t bucket_count;
+    int32_t entry_count;
+    int32_t capacity; // 0 for unbounded
+    memo_entry_t *newest;
+    memo_entry_t *oldest;
+    uint64_t hits;
+    uint64_t misses;
+} memo_table_t;
+
+// Promise made by delay or make-promise, shared by every copy of the value.
+// Forcing replaces the thunk with its value in place.
+typedef struct promise {
+    int32_t ref_count;
+    pval *thunk;
+    pval *value;
+} promise_t;
+
+#ifdef COROUTINE_USE_UCONTEXT
+typedef ucontext_t coroutine_context_t;
+#else
+typedef void *coroutine_context_t; // Saved stack pointer
+#endif
+
+// Generator made by make-generator, shared by every copy of the value; see
+// Generators.
+typedef struct generator {
+    int32_t ref_count;
+    pval *body;
+    char *stack;
+    coroutine_context_t context;
+    coroutine_context_t caller_context;
+    pval *transfer;
+    struct frame *frame;
+    int32_t depth;
+    bool started;
+    bool running;
+    bool finished;
+    bool cancelled;
+} generator_t;
+
+// Bytes made by serialize or read-bytes, shared by every copy of the value.
+// They never change once made.
+typedef struct byte_string {
+    int32_t ref_count;
+    size_t length;
+    uint8_t data[];
+} byte_string_t;
+
+// An interned value, with the table link and reference count that only
+// interned values need; see Hash-Consing.
+typedef struct cons_node {
+    uint64_t hash;
+    struct cons_node *next;
+    int32_t ref_count;
+    pval value;
+} cons_node_t;
+
+static cons_node_t *cons_node_of(pval *interned) {
+    return (cons_node_t *)((char *)interned - offsetof(cons_node_t, value));
+}
+
+// Multiple values in flight; see Multiple Values.
+#define MAX_VALUES 64
+
+static pval values_token = {.type = PVAL_VALUES};
+static pval *value_registers[MAX_VALUES];
+static int32_t value_count = 0;
+
+// Symbol Table
+// Every symbol name is stored once, here, and symbol values point at the
+// stored name instead of owning a copy. The parser looks names up straight
+// from the source text by pointer and length, so a symbol seen before costs
+// a hash lookup and no string allocation, and copying or deleting a symbol
+// never touches its name. Names live as long as the process, and two symbols
+// are equal exactly when their names are the same pointer. While parse
+// threads are running the table is shared between them and symbol_intern
+// takes symbol_lock; the rest of the interpreter is single-threaded and
+// never locks.
+typedef struct symbol_name {
+    struct symbol_name *next;
+    uint64_t hash;
+    size_t length;
+    char name[];
+} symbol_name_t;
+
+static symbol_name_t **symbol_buckets = NULL;
+static int32_t symbol_bucket_count = 0;
+static int32_t symbol_count = 0;
+static bool symbol_table_shared = false;
+static pthread_mutex_t symbol_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t hash_bytes(const char *bytes, size_t length) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static symbol_name_t *symbol_entry(const char *name) {
+    return (symbol_name_t *)(name - offsetof(symbol_name_t, name));
+}
+
+// Hash of an interned name, computed once when it was stored.
+static uint64_t symbol_hash(const char *name) {
+    return symbol_entry(name)->hash;
+}
+
+static bool symbol_table_grow(void) {
+    int32_t new_count = symbol_bucket_count > 0 ? symbol_bucket_count * 2 : 256;
+    symbol_name_t **new_buckets = calloc(new_count, sizeof(symbol_name_t *));
+    if (new_buckets == NULL) {
+        return false;
+    }
+    for (int32_t i = 0; i < symbol_bucket_count; i++) {
+        symbol_name_t *entry = symbol_buckets[i];
+        while (entry != NULL) {
+            symbol_name_t *next = entry->next;
+            symbol_name_t **bucket = &new_buckets[entry->hash & (new_count - 1)];
+            entry->next = *bucket;
+            *bucket = entry;
+            entry = next;
+        }
+    }
+    free(symbol_buckets);
+    symbol_buckets = new_buckets;
+    symbol_bucket_count = new_count;
+    return true;
+}
+
+static char *symbol_intern_hashed(const char *text, size_t length, uint64_t hash) {
+    if (symbol_count >= symbol_bucket_count && !symbol_table_grow()
+        && symbol_bucket_count == 0) {
+        return NULL;
+    }
+    symbol_name_t **bucket = &symbol_buckets[hash & (symbol_bucket_count - 1)];
+    for (symbol_name_t *entry = *bucket; entry != NULL; entry = entry->next) {
+        if (entry->hash == hash && entry->length == length
+            && memcmp(entry->name, text, length) == 0) {
+            return entry->name;
+        }
+    }
+    symbol_name_t *entry = malloc(sizeof(symbol_name_t) + length + 1);
+    if (entry == NULL) {
+        return NULL;
+    }
+    entry->hash = hash;
+    entry->length = length;
+    memcpy(entry->name, text, length);
+    entry->name[length] = '\0';
+    entry->next = *bucket;
+    *bucket = entry;
+    symbol_count++;
+    return entry->name;
+}
+
+// Returns the stored name equal to the first length bytes of text, storing
+// it on first sight, or NULL when out of memory.
+static char *symbol_intern(const char *text, size_t length) {
+    uint64_t hash = hash_bytes(text, length);
+    if (!symbol_table_shared) {
+        return symbol_intern_hashed(text, length, hash);
+    }
+    pthread_mutex_lock(&symbol_lock);
+    char *name = symbol_intern_hashed(text, length, hash);
+    pthread_mutex_unlock(&symbol_lock);
+    return name;
+}
+
 // PSI Constructors
 static pval *pval_number(double number_val);
 static pval *pval_bool(bool bool_val);
 static pval *pval_symbol(const char *symbol_str);
+static pval *pval_symbol_len(const char *symbol_str, size_t length);
+static pval *pval_symbol_interned(char *name);
 static pval *pval_function(builtin_function_ptr func);
+static pval *pval_closure(lambda_code_t *code, pval **captures);
+static pval *pval_promise(promise_t *promise);
+static pval *pval_generator(struct generator *generator);
+static pval *pval_bytes(byte_string_t *bytes);
 static pval *pval_list(void);
 static pval *pval_error(const char *error_type, const char *error_message);
 static void pval_delete(pval *target_value);
-static void pval_print(pval *target_value);
+static void lambda_code_release(lambda_code_t *code);
+static void memo_table_release(struct memo_table *table);
+static void cons_table_remove(pval *target_value);
+static void promise_release(promise_t *promise);
+static void generator_release(struct generator *generator);
+static void byte_string_release(byte_string_t *bytes);
+static void values_release(void);
+static MAIN_ONLY void pval_print(pval *target_value);
+static int32_t format_number(double number, char *text);
 static void pval_add(pval *target_list, pval *new_item);
-static pval *pval_parse(char **input_ptr);
+static pval *pval_copy(pval *source_value);
+static bool pval_is_truthy(pval *target_value);
+static uint64_t pval_hash(pval *target_value);
+static bool pval_equal(pval *first_value, pval *second_value);
+static pval *pval_hash_cons(pval *target_value);
+struct parse_source;
+static MAIN_ONLY pval *pval_parse(char **input_ptr, const struct parse_source *source);
 static pval *pval_eval(pval *input_value);
+static pval *closure_call(pval *closure, pval **args, int32_t arg_count);
+pval *pval_apply(pval **evaluated_items, int32_t item_count);
+static bool is_special_form(pval *input_value);
 
 pval *pval_number(double number_val) {
     pval *new_value = malloc(sizeof(pval));
@@ -125,18 +422,25 @@ pval *pval_bool(bool bool_val) {
 }
 
 pval *pval_symbol(const char *symbol_str) {
+    return pval_symbol_len(symbol_str, strlen(symbol_str));
+}
+
+// Symbol of the first length bytes of symbol_str, which need not be
+// NUL-terminated.
+pval *pval_symbol_len(const char *symbol_str, size_t length) {
+    char *name = symbol_intern(symbol_str, length);
+    return name == NULL ? NULL : pval_symbol_interned(name);
+}
+
+// Symbol whose name was returned by symbol_intern.
+pval *pval_symbol_interned(char *name) {
     pval *new_value = malloc(sizeof(pval));
     if (new_value == NULL) {
         return NULL;
     }
-    char *symbol_copy = strdup(symbol_str);
-    if (symbol_copy == NULL) {
-        free(new_value);
-        return NULL;
-    }
     *new_value = (pval){
         .type = PVAL_SYMBOL,
-        .symbol = symbol_copy
+        .symbol = name
     };
     return new_value;
 }
@@ -153,6 +457,59 @@ pval *pval_function(builtin_function_ptr func_ptr) {
     return new_value;
 }
 
+pval *pval_closure(lambda_code_t *code, pval **captures) {
+    pval *new_value = malloc(sizeof(pval));
+    if (new_value == NULL) {
+        return NULL;
+    }
+    code->ref_count++;
+    *new_value = (pval){
+        .type = PVAL_CLOSURE,
+        .code = code,
+        .captures = captures
+    };
+    return new_value;
+}
+
+pval *pval_promise(promise_t *promise) {
+    pval *new_value = malloc(sizeof(pval));
+    if (new_value == NULL) {
+        return NULL;
+    }
+    promise->ref_count++;
+    *new_value = (pval){
+        .type = PVAL_PROMISE,
+        .promise = promise
+    };
+    return new_value;
+}
+
+pval *pval_generator(generator_t *generator) {
+    pval *new_value = malloc(sizeof(pval));
+    if (new_value == NULL) {
+        return NULL;
+    }
+    generator->ref_count++;
+    *new_value = (pval){
+        .type = PVAL_GENERATOR,
+        .generator = generator
+    };
+    return new_value;
+}
+
+pval *pval_bytes(byte_string_t *bytes) {
+    pval *new_value = malloc(sizeof(pval));
+    if (new_value == NULL) {
+        return NULL;
+    }
+    bytes->ref_count++;
+    *new_value = (pval){
+        .type = PVAL_BYTES,
+        .bytes = bytes
+    };
+    return new_value;
+}
+
 pval *pval_list(void) {
     pval *new_value = malloc(sizeof(pval));
     if (new_value == NULL) {
@@ -172,6 +529,15 @@ pval *pval_list(void) {
     return new_value;
 }
 
+// Returns the call-site caches of list, making them on first use, or NULL
+// if they cannot be allocated.
+static call_site_t *call_site_of(pval *list) {
+    if (list->site == NULL) {
+        list->site = calloc(1, sizeof(call_site_t));
+    }
+    return list->site;
+}
+
 pval *pval_error(const char *error_type, const char *error_message) {
     pval *new_value = malloc(sizeof(pval));
     if (new_value == NULL) {
@@ -195,67 +561,278 @@ pval *pval_error(const char *error_type, const char *error_message) {
 
 // P Value Handling Functions
 void pval_delete(pval *target_value) {
-    if (target_value == NULL) {
+    work_stack_t pending;
+    work_stack_init(&pending, sizeof(pval *));
+    while (target_value != NULL) {
+        // A hash-consed value is only freed by its last owner.
+        bool still_shared = target_value->hash_consed
+            && --cons_node_of(target_value)->ref_count > 0;
+        if (!still_shared) {
+            if (target_value->hash_consed) {
+                cons_table_remove(target_value);
+            }
+            switch (target_value->type) {
+            case PVAL_LIST:
+                for (int32_t i = 0; i < target_value->list_count; i++) {
+                    pval **slot = work_stack_push(&pending);
+                    if (slot == NULL) {
+                        break; // Out of memory: leak the rest rather than crash
+                    }
+                    *slot = target_value->list_items[i];
+                }
+                free(target_value->list_items);
+                if (target_value->site != NULL) {
+                    lambda_code_release(target_value->site->code);
+                    if (target_value->site->expansion != NULL) {
+                        pval **slot = work_stack_push(&pending);
+                        if (slot != NULL) {
+                            *slot = target_value->site->expansion;
+                        }
+                    }
+                    free(target_value->site);
+                }
+                break;
+            case PVAL_CLOSURE:
+                for (int32_t i = 0; i < target_value->code->capture_count; i++) {
+                    pval **slot = work_stack_push(&pending);
+                    if (slot == NULL) {
+                        break;
+                    }
+                    *slot = target_value->captures[i];
+                }
+                free(target_value->captures);
+                lambda_code_release(target_value->code);
+                memo_table_release(target_value->memo);
+                break;
+            case PVAL_PROMISE:
+                promise_release(target_value->promise);
+                break;
+            case PVAL_GENERATOR:
+                generator_release(target_value->generator);
+                break;
+            case PVAL_VALUES:
+                values_release();
+                break;
+            case PVAL_BYTES:
+                byte_string_release(target_value->bytes);
+                break;
+            case PVAL_ERROR:
+                free(target_value->error_type);
+                free(target_value->error_message);
+                break;
+            case PVAL_NUMBER:
+            case PVAL_BOOL:
+            case PVAL_SYMBOL: // Names belong to the symbol table
+            case PVAL_FUNCTION:
+                break;
+            }
+            if (target_value->hash_consed) {
+                free(cons_node_of(target_value));
+            } else if (target_value != &values_token) {
+                free(target_value);
+            }
+        }
+
+        target_value = NULL;
+        if (pending.count > 0) {
+            target_value = *(pval **)work_stack_top(&pending);
+            pending.count--;
+        }
+    }
+    work_stack_free(&pending);
+}
+
+// Returns a promise of thunk, or one already holding value; takes ownership
+// of both.
+static promise_t *promise_new(pval *thunk, pval *value) {
+    promise_t *promise = malloc(sizeof(promise_t));
+    if (promise == NULL) {
+        return NULL;
+    }
+    *promise = (promise_t){0, thunk, value};
+    return promise;
+}
+
+void promise_release(promise_t *promise) {
+    if (--promise->ref_count > 0) {
         return;
     }
-    switch (target_value->type) {
-    case PVAL_SYMBOL:
-        free(target_value->symbol);
-        break;
-    case PVAL_LIST:
-        for (int32_t i = 0; i < target_value->list_count; i++) {
-            pval_delete(target_value->list_items[i]);
-        }
-        free(target_value->list_items);
-        break;
-    case PVAL_ERROR:
-        free(target_value->error_type);
-        free(target_value->error_message);
-        break;
-    case PVAL_NUMBER:
-    case PVAL_BOOL:
-    case PVAL_FUNCTION:
-        break;
+    pval_delete(promise->thunk);
+    pval_delete(promise->value);
+    free(promise);
+}
+
+// Returns a byte string holding a copy of length bytes from data.
+static byte_string_t *byte_string_new(const uint8_t *data, size_t length) {
+    byte_string_t *bytes = malloc(sizeof(byte_string_t) + length);
+    if (bytes == NULL) {
+        return NULL;
+    }
+    bytes->ref_count = 0;
+    bytes->length = length;
+    if (length > 0) {
+        memcpy(bytes->data, data, length);
     }
-    free(target_value);
+    return bytes;
 }
 
-void pval_print(pval *target_value) {
-    if (target_value == NULL) {
-        printf("NULL_PVAL");
+void byte_string_release(byte_string_t *bytes) {
+    if (--bytes->ref_count > 0) {
         return;
     }
-    switch (target_value->type) {
-    case PVAL_NUMBER:
-        if (target_value->number == (int32_t)target_value->number) {
-            printf("%d", (int32_t)target_value->number);
+    free(bytes);
+}
+
+void lambda_code_release(lambda_code_t *code) {
+    if (code == NULL || --code->ref_count > 0) {
+        return;
+    }
+    free(code->names); // The names themselves belong to the symbol table
+    pval_delete(code->body);
+    free(code);
+}
+
+// Output Buffer
+// Printing appends to one growable buffer instead of calling printf for each
+// atom and parenthesis, and the whole result is handed to stdout in a single
+// write once it is complete. The buffer keeps its capacity between results.
+// If it cannot grow, what it holds is flushed and the text is written
+// directly, so output is never lost.
+typedef struct output_buffer {
+    char *data;
+    size_t length;
+    size_t capacity;
+} output_buffer_t;
+
+static output_buffer_t print_output;
+
+static void output_flush(void) {
+    if (print_output.length > 0) {
+        fwrite(print_output.data, 1, print_output.length, stdout);
+        print_output.length = 0;
+    }
+}
+
+static void output_bytes(const char *bytes, size_t length) {
+    if (print_output.capacity - print_output.length < length) {
+        size_t new_capacity = print_output.capacity > 0 ? print_output.capacity : 256;
+        while (new_capacity - print_output.length < length && new_capacity <= SIZE_MAX / 2) {
+            new_capacity *= 2;
+        }
+        char *grown = new_capacity - print_output.length >= length
+            ? realloc(print_output.data, new_capacity) : NULL;
+        if (grown == NULL) {
+            output_flush();
+            fwrite(bytes, 1, length, stdout);
+            return;
+        }
+        print_output.data = grown;
+        print_output.capacity = new_capacity;
+    }
+    memcpy(print_output.data + print_output.length, bytes, length);
+    print_output.length += length;
+}
+
+static void output_text(const char *text) {
+    output_bytes(text, strlen(text));
+}
+
+typedef struct print_frame {
+    pval *list;
+    int32_t next_item;
+} print_frame_t;
+
+// Appends the printed form of target_value to the output buffer.
+static void pval_write(pval *target_value) {
+    work_stack_t open_lists;
+    work_stack_init(&open_lists, sizeof(print_frame_t));
+    while (true) {
+        if (target_value == NULL) {
+            output_text("NULL_PVAL");
         } else {
-            printf("%.3f", target_value->number);
+            switch (target_value->type) {
+            case PVAL_NUMBER: {
+                char number_text[32];
+                output_bytes(number_text, format_number(target_value->number, number_text));
+                break;
+            }
+            case PVAL_BOOL:
+                output_text(target_value->boolean ? "#t" : "#f");
+                break;
+            case PVAL_SYMBOL:
+                output_text(target_value->symbol);
+                break;
+            case PVAL_LIST: {
+                print_frame_t *frame = work_stack_push(&open_lists);
+                if (frame == NULL) {
+                    output_text("...");
+                    break;
+                }
+                *frame = (print_frame_t){target_value, 0};
+                output_text("(");
+                break;
+            }
+            case PVAL_ERROR:
+                output_text("$error{");
+                output_text(target_value->error_type);
+                output_text(" ");
+                output_text(target_value->error_message);
+                output_text("}");
+                break;
+            case PVAL_FUNCTION:
+                output_text("<function>");
+                break;
+            case PVAL_CLOSURE:
+                output_text("<lambda>");
+                break;
+            case PVAL_PROMISE:
+                output_text("<promise>");
+                break;
+            case PVAL_GENERATOR:
+                output_text("<generator>");
+                break;
+            case PVAL_BYTES: {
+                char length_text[32];
+                snprintf(length_text, sizeof(length_text), "<bytes %zu>",
+                         target_value->bytes->length);
+                output_text(length_text);
+                break;
+            }
+            case PVAL_VALUES:
+                for (int32_t i = 0; i < value_count; i++) {
+                    if (i > 0) {
+                        output_text(" ");
+                    }
+                    pval_write(value_registers[i]);
+                }
+                break;
+            }
         }
-        break;
-    case PVAL_BOOL:
-        printf(target_value->boolean ? "#t" : "#f");
-        break;
-    case PVAL_SYMBOL:
-        printf("%s", target_value->symbol);
-        break;
-    case PVAL_LIST:
-        printf("(");
-        for (int32_t i = 0; i < target_value->list_count; i++) {
-            pval_print(target_value->list_items[i]);
-            if (i < target_value->list_count - 1) {
-                printf(" ");
+
+        // Move on to the next item of the innermost unfinished list.
+        target_value = NULL;
+        while (open_lists.count > 0) {
+            print_frame_t *frame = work_stack_top(&open_lists);
+            if (frame->next_item < frame->list->list_count) {
+                if (frame->next_item > 0) {
+                    output_text(" ");
+                }
+                target_value = frame->list->list_items[frame->next_item++];
+                break;
             }
+            output_text(")");
+            open_lists.count--;
+        }
+        if (target_value == NULL) {
+            break;
         }
-        printf(")");
-        break;
-    case PVAL_ERROR:
-        printf("$error{%s %s}", target_value->error_type, target_value->error_message);
-        break;
-    case PVAL_FUNCTION:
-        printf("<function>");
-        break;
     }
+    work_stack_free(&open_lists);
+}
+
+void pval_print(pval *target_value) {
+    pval_write(target_value);
+    output_flush();
 }
 
 
@@ -285,368 +862,6198 @@ void pval_add(pval *target_list, pval *new_item) {
     }
 }
 
-// Interpretor Parser
-static void skip_whitespace(char **input_ptr) {
-    while (isspace(**input_ptr)) {
-        (*input_ptr)++;
+static pval *pval_copy_atom(pval *source_value) {
+    switch (source_value->type) {
+    case PVAL_NUMBER:
+        return pval_number(source_value->number);
+    case PVAL_BOOL:
+        return pval_bool(source_value->boolean);
+    case PVAL_SYMBOL:
+        return pval_symbol_interned(source_value->symbol);
+    case PVAL_FUNCTION:
+        return pval_function(source_value->function);
+    case PVAL_CLOSURE: {
+        int32_t capture_count = source_value->code->capture_count;
+        pval **captures = NULL;
+        if (capture_count > 0) {
+            captures = malloc(capture_count * sizeof(pval *));
+            if (captures == NULL) {
+                return NULL;
+            }
+            for (int32_t i = 0; i < capture_count; i++) {
+                captures[i] = pval_copy(source_value->captures[i]);
+            }
+        }
+        pval *copied_closure = pval_closure(source_value->code, captures);
+        if (copied_closure == NULL) {
+            for (int32_t i = 0; i < capture_count; i++) {
+                pval_delete(captures[i]);
+            }
+            free(captures);
+        } else if (source_value->memo != NULL) {
+            copied_closure->memo = source_value->memo;
+            copied_closure->memo->ref_count++;
+        }
+        return copied_closure;
+    }
+    case PVAL_PROMISE:
+        return pval_promise(source_value->promise);
+    case PVAL_GENERATOR:
+        return pval_generator(source_value->generator);
+    case PVAL_BYTES:
+        return pval_bytes(source_value->bytes);
+    case PVAL_VALUES:
+        return pval_error("ValuesError", "Multiple values where one value is expected");
+    case PVAL_ERROR:
+        return pval_error(source_value->error_type, source_value->error_message);
+    case PVAL_LIST:
+        return pval_list();
     }
+    return NULL;
 }
 
-pval *pval_parse(char **input_ptr) {
-    skip_whitespace(input_ptr);
-    if (**input_ptr == '\0') {
+typedef struct copy_frame {
+    pval *source;
+    pval *copy;
+    int32_t next_item;
+} copy_frame_t;
+
+pval *pval_copy(pval *source_value) {
+    if (source_value == NULL) {
         return NULL;
     }
+    if (source_value->hash_consed) {
+        cons_node_of(source_value)->ref_count++;
+        return source_value;
+    }
+    pval *copied_value = pval_copy_atom(source_value);
+    if (copied_value == NULL || source_value->type != PVAL_LIST) {
+        return copied_value;
+    }
 
-    if (**input_ptr == '(') {
-        (*input_ptr)++;
-        pval *list_value = pval_list();
-        if (list_value == NULL) {
-            return pval_error("MemoryError", "Failed to allocate list");
-        }
-
-        while (true) {
-            skip_whitespace(input_ptr);
-            if (**input_ptr == '\0') {
-                pval_delete(list_value);
-                return pval_error("SyntaxError", "Unexpected EOF, expected ')'");
-            }
-            if (**input_ptr == ')') {
-                (*input_ptr)++;
-                break;
-            }
-            pval *parsed_item = pval_parse(input_ptr);
-            if (parsed_item == NULL) {
-                pval_delete(list_value);
-                return pval_error("SyntaxError", "Invalid expression inside list");
-            }
-            if (parsed_item->type == PVAL_ERROR) {
-                pval_delete(list_value);
-                return parsed_item;
-            }
-            pval_add(list_value, parsed_item);
+    work_stack_t open_lists;
+    work_stack_init(&open_lists, sizeof(copy_frame_t));
+    copy_frame_t *root = work_stack_push(&open_lists);
+    *root = (copy_frame_t){source_value, copied_value, 0};
+    while (open_lists.count > 0) {
+        copy_frame_t *frame = work_stack_top(&open_lists);
+        if (frame->next_item == frame->source->list_count) {
+            open_lists.count--;
+            continue;
         }
-        return list_value;
-    } else if (isdigit(**input_ptr) || (**input_ptr == '-' && isdigit((*input_ptr)[1]))
-               || **input_ptr == '.') {
-        char *end_ptr;
-        double parsed_num = strtod(*input_ptr, &end_ptr);
-        if (end_ptr == *input_ptr) {
-            return pval_error("SyntaxError", "Invalid number format");
+        pval *source_item = frame->source->list_items[frame->next_item++];
+        if (source_item->hash_consed) {
+            cons_node_of(source_item)->ref_count++;
+            pval_add(frame->copy, source_item);
+            continue;
         }
-        *input_ptr = end_ptr;
-        return pval_number(parsed_num);
-    } else if (strncmp(*input_ptr, "#t", 2) == 0) {
-        *input_ptr += 2;
-        return pval_bool(true);
-    } else if (strncmp(*input_ptr, "#f", 2) == 0) {
-        *input_ptr += 2;
-        return pval_bool(false);
-    } else {
-        char symbol_buffer[256];
-        int32_t i = 0;
-        while (**input_ptr != '\0' && !isspace(**input_ptr) && **input_ptr != '('
-               && **input_ptr != ')') {
-            if (i >= sizeof(symbol_buffer) - 1) {
-                return pval_error("SyntaxError", "Symbol too long");
-            }
-            symbol_buffer[i++] = **input_ptr;
-            (*input_ptr)++;
+        pval *copied_item = pval_copy_atom(source_item);
+        if (copied_item == NULL) {
+            pval_delete(copied_value);
+            copied_value = NULL;
+            break;
         }
-        if (i == 0) {
-            return pval_error("SyntaxError", "Empty symbol or unparsable token");
+        pval_add(frame->copy, copied_item);
+        if (source_item->type == PVAL_LIST && source_item->list_count > 0) {
+            copy_frame_t *child = work_stack_push(&open_lists);
+            if (child == NULL) {
+                pval_delete(copied_value);
+                copied_value = NULL;
+                break;
+            }
+            *child = (copy_frame_t){source_item, copied_item, 0};
         }
-        symbol_buffer[i] = '\0';
-        return pval_symbol(symbol_buffer);
     }
+    work_stack_free(&open_lists);
+    return copied_value;
 }
 
-// Builtin PSI Op Functions
-pval *builtin_add(pval **args, int32_t arg_count);
-pval *builtin_sub(pval **args, int32_t arg_count);
-pval *builtin_mul(pval **args, int32_t arg_count);
-pval *builtin_div(pval **args, int32_t arg_count);
-pval *builtin_eq(pval **args, int32_t arg_count);
-pval *builtin_quit(pval **args, int32_t arg_count);
+// Everything except #f counts as true in a condition.
+bool pval_is_truthy(pval *target_value) {
+    return target_value->type != PVAL_BOOL || target_value->boolean;
+}
 
-pval *builtin_add(pval **args, int32_t arg_count) {
-    double running_sum = 0.0;
-    if (arg_count == 0) {
+// Structural Hash and Equality
+// One notion of equality for the whole interpreter: = compares with
+// pval_equal, and memo tables hash their keys with pval_hash. Lists and
+// closures compare item by item, except that a shared node is equal to
+// itself without a walk. Numbers are equal within NUMBER_EQUAL_EPSILON but
+// hash by their exact value, so two numbers that are only equal within the
+// tolerance can hash apart; for a memo table that costs a miss, never a
+// wrong answer. Both walk the values with a work stack.
+#define NUMBER_EQUAL_EPSILON 1e-10
+
+static uint64_t hash_mix(uint64_t hash, uint64_t value) {
+    hash = (hash ^ value) * 0x100000001b3ULL;
+    return hash ^ (hash >> 29);
+}
+
+static uint64_t hash_string(const char *string) {
+    return hash_bytes(string, strlen(string));
+}
+
+// Hash of a value without its items: the whole hash for atoms, and the
+// starting point that a list's or closure's item hashes are mixed into.
+static uint64_t hash_header(pval *target_value) {
+    uint64_t hash = hash_mix(0xcbf29ce484222325ULL, target_value->type);
+    switch (target_value->type) {
+    case PVAL_NUMBER: {
+        double number = target_value->number == 0.0 ? 0.0 : target_value->number;
+        uint64_t bits;
+        memcpy(&bits, &number, sizeof(bits));
+        return hash_mix(hash, bits);
+    }
+    case PVAL_BOOL:
+        return hash_mix(hash, target_value->boolean);
+    case PVAL_SYMBOL:
+        return hash_mix(hash, symbol_hash(target_value->symbol));
+    case PVAL_ERROR:
+        hash = hash_mix(hash, hash_string(target_value->error_type));
+        return hash_mix(hash, hash_string(target_value->error_message));
+    case PVAL_FUNCTION:
+        return hash_mix(hash, (uint64_t)(uintptr_t)target_value->function);
+    case PVAL_CLOSURE:
+        return hash_mix(hash, (uint64_t)(uintptr_t)target_value->code);
+    case PVAL_PROMISE:
+        return hash_mix(hash, (uint64_t)(uintptr_t)target_value->promise);
+    case PVAL_GENERATOR:
+        return hash_mix(hash, (uint64_t)(uintptr_t)target_value->generator);
+    case PVAL_VALUES:
+        return hash;
+    case PVAL_BYTES:
+        return hash_mix(hash, hash_bytes((const char *)target_value->bytes->data,
+                                         target_value->bytes->length));
+    case PVAL_LIST:
+        return hash_mix(hash, (uint64_t)target_value->list_count);
+    }
+    return hash;
+}
+
+static pval **pval_children(pval *target_value, int32_t *child_count) {
+    if (target_value->type == PVAL_LIST) {
+        *child_count = target_value->list_count;
+        return target_value->list_items;
+    }
+    if (target_value->type == PVAL_CLOSURE) {
+        *child_count = target_value->code->capture_count;
+        return target_value->captures;
+    }
+    *child_count = 0;
+    return NULL;
+}
+
+typedef struct hash_frame {
+    pval *node;
+    int32_t next_item;
+    uint64_t hash;
+} hash_frame_t;
+
+// A container's hash mixes its header with its items' hashes in order, so a
+// hash-consed subtree contributes the hash it stored when it was interned.
+uint64_t pval_hash(pval *target_value) {
+    if (target_value->hash_consed) {
+        return cons_node_of(target_value)->hash;
+    }
+    int32_t child_count;
+    if (pval_children(target_value, &child_count) == NULL) {
+        return hash_header(target_value);
+    }
+
+    work_stack_t open_nodes;
+    work_stack_init(&open_nodes, sizeof(hash_frame_t));
+    hash_frame_t *root = work_stack_push(&open_nodes);
+    *root = (hash_frame_t){target_value, 0, hash_header(target_value)};
+    uint64_t hash = root->hash;
+    while (open_nodes.count > 0) {
+        hash_frame_t *frame = work_stack_top(&open_nodes);
+        pval **children = pval_children(frame->node, &child_count);
+        if (frame->next_item == child_count) {
+            hash = frame->hash;
+            open_nodes.count--;
+            if (open_nodes.count > 0) {
+                frame = work_stack_top(&open_nodes);
+                frame->hash = hash_mix(frame->hash, hash);
+            }
+            continue;
+        }
+        pval *child = children[frame->next_item++];
+        int32_t grandchild_count;
+        if (child->hash_consed || pval_children(child, &grandchild_count) == NULL) {
+            frame->hash = hash_mix(frame->hash, pval_hash(child));
+            continue;
+        }
+        hash_frame_t *child_frame = work_stack_push(&open_nodes);
+        if (child_frame == NULL) {
+            frame->hash = hash_mix(frame->hash, hash_header(child)); // Out of memory
+            continue;
+        }
+        *child_frame = (hash_frame_t){child, 0, hash_header(child)};
+    }
+    work_stack_free(&open_nodes);
+    return hash;
+}
+
+typedef struct equal_pair {
+    pval *first;
+    pval *second;
+} equal_pair_t;
+
+bool pval_equal(pval *first_value, pval *second_value) {
+    work_stack_t pending;
+    work_stack_init(&pending, sizeof(equal_pair_t));
+    equal_pair_t *root = work_stack_push(&pending);
+    *root = (equal_pair_t){first_value, second_value};
+    bool equal = true;
+    while (equal && pending.count > 0) {
+        equal_pair_t pair = *(equal_pair_t *)work_stack_top(&pending);
+        pending.count--;
+        if (pair.first == pair.second) {
+            continue;
+        }
+        if (pair.first->type != pair.second->type) {
+            equal = false;
+            break;
+        }
+
+        switch (pair.first->type) {
+        case PVAL_NUMBER:
+            equal = fabs(pair.first->number - pair.second->number) < NUMBER_EQUAL_EPSILON;
+            break;
+        case PVAL_BOOL:
+            equal = pair.first->boolean == pair.second->boolean;
+            break;
+        case PVAL_SYMBOL:
+            equal = pair.first->symbol == pair.second->symbol;
+            break;
+        case PVAL_ERROR:
+            equal = strcmp(pair.first->error_type, pair.second->error_type) == 0
+                && strcmp(pair.first->error_message, pair.second->error_message) == 0;
+            break;
+        case PVAL_FUNCTION:
+            equal = pair.first->function == pair.second->function;
+            break;
+        case PVAL_CLOSURE:
+            equal = pair.first->code == pair.second->code;
+            break;
+        case PVAL_PROMISE:
+            equal = pair.first->promise == pair.second->promise;
+            break;
+        case PVAL_GENERATOR:
+            equal = pair.first->generator == pair.second->generator;
+            break;
+        case PVAL_VALUES:
+            break; // There is only the one token, so both are it
+        case PVAL_BYTES:
+            equal = pair.first->bytes->length == pair.second->bytes->length
+                && memcmp(pair.first->bytes->data, pair.second->bytes->data,
+                          pair.first->bytes->length) == 0;
+            break;
+        case PVAL_LIST:
+            equal = pair.first->list_count == pair.second->list_count;
+            break;
+        }
+        int32_t item_count;
+        pval **first_items = pval_children(pair.first, &item_count);
+        pval **second_items = pval_children(pair.second, &item_count);
+        for (int32_t i = item_count - 1; equal && i >= 0; i--) {
+            equal_pair_t *item_pair = work_stack_push(&pending);
+            if (item_pair == NULL) {
+                equal = false; // Out of memory: report a mismatch rather than guess
+                break;
+            }
+            *item_pair = (equal_pair_t){first_items[i], second_items[i]};
+        }
+    }
+    work_stack_free(&pending);
+    return equal;
+}
+
+// Hash-Consing
+// With --hash-cons, parsed data and memo table entries are interned: a value
+// structurally identical to a live interned one becomes that same node, so
+// repeated subtrees are stored once and equal interned values compare by
+// pointer. Interned nodes are immutable and reference counted; pval_copy
+// shares them and pval_delete frees them with their last owner. The table
+// is weak: it holds no references and a node leaves it when freed. Interning
+// moves a value into a cons_node_t holding its hash, chain link and count,
+// so a value that is never interned carries only the hash_consed flag.
+// Only atoms and lists without symbols are interned. A list with symbols can
+// be a call site or a lambda, whose cached classification and captures
+// depend on the frame it is evaluated in, so it must stay unshared.
+#define CONS_INITIAL_BUCKETS 256
+
+static bool hash_cons_enabled = false;
+static cons_node_t **cons_buckets = NULL;
+static int32_t cons_bucket_count = 0;
+static int32_t cons_count = 0;
+
+static bool cons_eligible(pval *target_value) {
+    switch (target_value->type) {
+    case PVAL_NUMBER:
+    case PVAL_BOOL:
+    case PVAL_SYMBOL:
+        return true;
+    case PVAL_LIST:
+        for (int32_t i = 0; i < target_value->list_count; i++) {
+            pval *item = target_value->list_items[i];
+            if (!item->hash_consed || item->type == PVAL_SYMBOL) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Exact identity for interning: numbers by value bits, lists by the
+// identity of their already interned items.
+static bool cons_same(pval *interned, pval *candidate) {
+    if (interned->type != candidate->type) {
+        return false;
+    }
+    switch (interned->type) {
+    case PVAL_NUMBER:
+        return memcmp(&interned->number, &candidate->number, sizeof(double)) == 0;
+    case PVAL_BOOL:
+        return interned->boolean == candidate->boolean;
+    case PVAL_SYMBOL:
+        return interned->symbol == candidate->symbol;
+    case PVAL_LIST:
+        if (interned->list_count != candidate->list_count) {
+            return false;
+        }
+        for (int32_t i = 0; i < interned->list_count; i++) {
+            if (interned->list_items[i] != candidate->list_items[i]) {
+                return false;
+            }
+        }
+        return true;
+    default:
+        return false;
+    }
+}
+
+static void cons_grow(void) {
+    int32_t new_count = cons_bucket_count == 0 ? CONS_INITIAL_BUCKETS : cons_bucket_count * 2;
+    cons_node_t **buckets = calloc(new_count, sizeof(cons_node_t *));
+    if (buckets == NULL) {
+        return; // Keep the longer chains
+    }
+    for (int32_t i = 0; i < cons_bucket_count; i++) {
+        cons_node_t *node = cons_buckets[i];
+        while (node != NULL) {
+            cons_node_t *next = node->next;
+            cons_node_t **bucket = &buckets[node->hash & (new_count - 1)];
+            node->next = *bucket;
+            *bucket = node;
+            node = next;
+        }
+    }
+    free(cons_buckets);
+    cons_buckets = buckets;
+    cons_bucket_count = new_count;
+}
+
+// Returns the interned node identical to target_value, which is consumed.
+// The items of a list must already be interned for the list to be.
+pval *pval_hash_cons(pval *target_value) {
+    if (!hash_cons_enabled || target_value == NULL || target_value->hash_consed
+        || !cons_eligible(target_value)) {
+        return target_value;
+    }
+    uint64_t hash = pval_hash(target_value);
+    if (cons_count > 0) {
+        cons_node_t *node = cons_buckets[hash & (cons_bucket_count - 1)];
+        for (; node != NULL; node = node->next) {
+            if (node->hash == hash && cons_same(&node->value, target_value)) {
+                node->ref_count++;
+                pval_delete(target_value);
+                return &node->value;
+            }
+        }
+    }
+    if (cons_count >= cons_bucket_count) {
+        cons_grow();
+        if (cons_bucket_count == 0) {
+            return target_value;
+        }
+    }
+    cons_node_t *node = malloc(sizeof(cons_node_t));
+    if (node == NULL) {
+        return target_value; // Stays an ordinary value
+    }
+    cons_node_t **bucket = &cons_buckets[hash & (cons_bucket_count - 1)];
+    *node = (cons_node_t){hash, *bucket, 1, *target_value};
+    node->value.hash_consed = true;
+    free(target_value); // Its contents moved into the node
+    *bucket = node;
+    cons_count++;
+    return &node->value;
+}
+
+void cons_table_remove(pval *target_value) {
+    cons_node_t *node = cons_node_of(target_value);
+    cons_node_t **link = &cons_buckets[node->hash & (cons_bucket_count - 1)];
+    while (*link != node) {
+        link = &(*link)->next;
+    }
+    *link = node->next;
+    cons_count--;
+}
+
+// Memoization
+// A memoized closure carries a table from argument tuples to results, so a
+// call whose arguments equal an earlier call's is answered without running
+// the body. Copies of the closure share the table. Entries are kept in
+// least-recently-used order; a table with a capacity evicts its oldest entry
+// once full. Error results and multiple values are never stored.
+#define MEMO_INITIAL_BUCKETS 16
+
+static memo_table_t *memo_table_new(int32_t capacity) {
+    memo_table_t *table = malloc(sizeof(memo_table_t));
+    memo_entry_t **buckets = calloc(MEMO_INITIAL_BUCKETS, sizeof(memo_entry_t *));
+    if (table == NULL || buckets == NULL) {
+        free(table);
+        free(buckets);
+        return NULL;
+    }
+    *table = (memo_table_t){
+        .ref_count = 1,
+        .buckets = buckets,
+        .bucket_count = MEMO_INITIAL_BUCKETS,
+        .capacity = capacity
+    };
+    return table;
+}
+
+static void memo_entry_free(memo_entry_t *entry) {
+    for (int32_t i = 0; i < entry->arg_count; i++) {
+        pval_delete(entry->args[i]);
+    }
+    free(entry->args);
+    pval_delete(entry->result);
+    free(entry);
+}
+
+void memo_table_release(memo_table_t *table) {
+    if (table == NULL || --table->ref_count > 0) {
+        return;
+    }
+    memo_entry_t *entry = table->newest;
+    while (entry != NULL) {
+        memo_entry_t *older = entry->older;
+        memo_entry_free(entry);
+        entry = older;
+    }
+    free(table->buckets);
+    free(table);
+}
+
+static uint64_t memo_args_hash(pval **args, int32_t arg_count) {
+    uint64_t hash = hash_mix(0xcbf29ce484222325ULL, (uint64_t)arg_count);
+    for (int32_t i = 0; i < arg_count; i++) {
+        hash = hash_mix(hash, pval_hash(args[i]));
+    }
+    return hash;
+}
+
+static void memo_unlink(memo_table_t *table, memo_entry_t *entry) {
+    if (entry->newer != NULL) {
+        entry->newer->older = entry->older;
+    } else {
+        table->newest = entry->older;
+    }
+    if (entry->older != NULL) {
+        entry->older->newer = entry->newer;
+    } else {
+        table->oldest = entry->newer;
+    }
+}
+
+static void memo_push_newest(memo_table_t *table, memo_entry_t *entry) {
+    entry->newer = NULL;
+    entry->older = table->newest;
+    if (table->newest != NULL) {
+        table->newest->newer = entry;
+    } else {
+        table->oldest = entry;
+    }
+    table->newest = entry;
+}
+
+// Returns the stored result for these arguments, or NULL, and counts the hit
+// or miss. A hit becomes the most recently used entry.
+static pval *memo_lookup(memo_table_t *table, uint64_t hash, pval **args, int32_t arg_count) {
+    memo_entry_t *entry = table->buckets[hash & (table->bucket_count - 1)];
+    for (; entry != NULL; entry = entry->bucket_next) {
+        if (entry->hash != hash || entry->arg_count != arg_count) {
+            continue;
+        }
+        bool matches = true;
+        for (int32_t i = 0; matches && i < arg_count; i++) {
+            matches = pval_equal(entry->args[i], args[i]);
+        }
+        if (matches) {
+            table->hits++;
+            memo_unlink(table, entry);
+            memo_push_newest(table, entry);
+            return entry->result;
+        }
+    }
+    table->misses++;
+    return NULL;
+}
+
+static void memo_evict_oldest(memo_table_t *table) {
+    memo_entry_t *entry = table->oldest;
+    memo_entry_t **link = &table->buckets[entry->hash & (table->bucket_count - 1)];
+    while (*link != entry) {
+        link = &(*link)->bucket_next;
+    }
+    *link = entry->bucket_next;
+    memo_unlink(table, entry);
+    memo_entry_free(entry);
+    table->entry_count--;
+}
+
+static void memo_grow(memo_table_t *table) {
+    int32_t new_count = table->bucket_count * 2;
+    memo_entry_t **buckets = calloc(new_count, sizeof(memo_entry_t *));
+    if (buckets == NULL) {
+        return; // Keep the longer chains
+    }
+    for (memo_entry_t *entry = table->newest; entry != NULL; entry = entry->older) {
+        memo_entry_t **bucket = &buckets[entry->hash & (new_count - 1)];
+        entry->bucket_next = *bucket;
+        *bucket = entry;
+    }
+    free(table->buckets);
+    table->buckets = buckets;
+    table->bucket_count = new_count;
+}
+
+// Stores copies of the arguments and the result as the newest entry.
+static void memo_store(memo_table_t *table, uint64_t hash, pval **args, int32_t arg_count,
+                       pval *result) {
+    memo_entry_t *entry = malloc(sizeof(memo_entry_t));
+    pval **stored_args = malloc((arg_count + 1) * sizeof(pval *));
+    if (entry == NULL || stored_args == NULL) {
+        free(entry);
+        free(stored_args);
+        return; // The result just isn't remembered
+    }
+    for (int32_t i = 0; i < arg_count; i++) {
+        stored_args[i] = pval_hash_cons(pval_copy(args[i]));
+    }
+    *entry = (memo_entry_t){
+        .hash = hash,
+        .args = stored_args,
+        .arg_count = arg_count,
+        .result = pval_hash_cons(pval_copy(result))
+    };
+
+    if (table->capacity > 0 && table->entry_count >= table->capacity) {
+        memo_evict_oldest(table);
+    }
+    if (table->entry_count >= table->bucket_count) {
+        memo_grow(table);
+    }
+    memo_entry_t **bucket = &table->buckets[hash & (table->bucket_count - 1)];
+    entry->bucket_next = *bucket;
+    *bucket = entry;
+    memo_push_newest(table, entry);
+    table->entry_count++;
+}
+
+// Interpretor Parser
+// Structural Scanning
+// Whitespace, parentheses and the end of the text delimit every token, so
+// the parser and the reader only ask how many bytes to skip before the next
+// delimiter of some kind. With SIMD each block of sixteen bytes is compared
+// against all delimiters at once, and the position of the first one comes
+// from the resulting bit mask. A block can extend up to fifteen bytes past
+// the terminating '\0', so text handed to the parser must be followed by
+// PARSE_PADDING readable bytes; the reader and the source maps reserve them.
+#define PARSE_PADDING 16
+
+#if defined(STRUCTURAL_SSE2)
+typedef __m128i scan_block_t;
+#define SCAN_INDEX_SHIFT 0 // One mask bit per byte
+
+static scan_block_t scan_load(const char *text) {
+    return _mm_loadu_si128((const __m128i *)text);
+}
+
+static scan_block_t scan_equal(scan_block_t block, char c) {
+    return _mm_cmpeq_epi8(block, _mm_set1_epi8(c));
+}
+
+static scan_block_t scan_or(scan_block_t first, scan_block_t second) {
+    return _mm_or_si128(first, second);
+}
+
+static scan_block_t scan_not(scan_block_t block) {
+    return _mm_xor_si128(block, _mm_cmpeq_epi8(block, block));
+}
+
+// Bytes '\t' to '\r', and ' ': what isspace accepts in the C locale.
+static scan_block_t scan_space(scan_block_t block) {
+    __m128i offset = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+    __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(4)), offset);
+    return scan_or(control, scan_equal(block, ' '));
+}
+
+static uint64_t scan_mask(scan_block_t matches) {
+    return (uint32_t)_mm_movemask_epi8(matches);
+}
+#elif defined(STRUCTURAL_NEON)
+typedef uint8x16_t scan_block_t;
+#define SCAN_INDEX_SHIFT 2 // Four mask bits per byte
+
+static scan_block_t scan_load(const char *text) {
+    return vld1q_u8((const uint8_t *)text);
+}
+
+static scan_block_t scan_equal(scan_block_t block, char c) {
+    return vceqq_u8(block, vdupq_n_u8((uint8_t)c));
+}
+
+static scan_block_t scan_or(scan_block_t first, scan_block_t second) {
+    return vorrq_u8(first, second);
+}
+
+static scan_block_t scan_not(scan_block_t block) {
+    return vmvnq_u8(block);
+}
+
+static scan_block_t scan_space(scan_block_t block) {
+    uint8x16_t control = vcleq_u8(vsubq_u8(block, vdupq_n_u8('\t')), vdupq_n_u8(4));
+    return scan_or(control, scan_equal(block, ' '));
+}
+
+static uint64_t scan_mask(scan_block_t matches) {
+    uint8x8_t narrowed = vshrn_n_u16(vreinterpretq_u16_u8(matches), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+}
+#endif
+
+#if defined(STRUCTURAL_SSE2) || defined(STRUCTURAL_NEON)
+typedef enum {
+    SCAN_TO_NON_SPACE,
+    SCAN_TO_DELIMITER,   // Whitespace, a paren or '\0'
+    SCAN_TO_LIST_MARK    // A paren, '\n' or '\0'
+} scan_stop_t;
+
+static uint64_t scan_stops(scan_block_t block, scan_stop_t stop) {
+    scan_block_t paren = scan_or(scan_equal(block, '('), scan_equal(block, ')'));
+    switch (stop) {
+    case SCAN_TO_NON_SPACE:
+        return scan_mask(scan_not(scan_space(block)));
+    case SCAN_TO_DELIMITER:
+        return scan_mask(scan_or(scan_or(scan_space(block), paren), scan_equal(block, '\0')));
+    case SCAN_TO_LIST_MARK:
+        return scan_mask(scan_or(scan_or(paren, scan_equal(block, '\n')),
+                                 scan_equal(block, '\0')));
+    }
+    return 1;
+}
+
+// Number of bytes from text on before the first one that stop selects.
+static inline size_t scan_span(const char *text, scan_stop_t stop) {
+    for (size_t offset = 0;; offset += 16) {
+        uint64_t mask = scan_stops(scan_load(text + offset), stop);
+        if (mask != 0) {
+            return offset + (__builtin_ctzll(mask) >> SCAN_INDEX_SHIFT);
+        }
+    }
+}
+
+static size_t span_space(const char *text) {
+    return scan_span(text, SCAN_TO_NON_SPACE);
+}
+
+static size_t span_token(const char *text) {
+    return scan_span(text, SCAN_TO_DELIMITER);
+}
+
+static MAIN_ONLY size_t span_list_text(const char *text) {
+    return scan_span(text, SCAN_TO_LIST_MARK);
+}
+#else
+static size_t span_space(const char *text) {
+    size_t length = 0;
+    while (isspace((unsigned char)text[length])) {
+        length++;
+    }
+    return length;
+}
+
+static size_t span_token(const char *text) {
+    size_t length = 0;
+    while (text[length] != '\0' && !isspace((unsigned char)text[length])
+           && text[length] != '(' && text[length] != ')') {
+        length++;
+    }
+    return length;
+}
+
+static MAIN_ONLY size_t span_list_text(const char *text) {
+    size_t length = 0;
+    while (text[length] != '\0' && text[length] != '(' && text[length] != ')'
+           && text[length] != '\n') {
+        length++;
+    }
+    return length;
+}
+#endif
+
+static void skip_whitespace(char **input_ptr) {
+    *input_ptr += span_space(*input_ptr);
+}
+
+// Number Parsing
+// Numeric literals are read by a dedicated scanner instead of strtod. The
+// digits go into a 64-bit integer, so an integer literal of up to 15 or 16
+// digits is its own value. A decimal whose digits fit in 53 bits and whose
+// power of ten is at most 22 is one exact multiplication or division by an
+// exact power of ten. Everything else goes through the Eisel-Lemire
+// algorithm: the digits are multiplied by a 128-bit truncation of the power
+// of five, which determines the correctly rounded double. Only a literal with
+// more than 19 significant digits whose truncation leaves the rounding
+// undecided falls back to strtod. The results are bit for bit those of
+// strtod in the C locale, without depending on the locale.
+#define POWER_OF_FIVE_MIN (-342)
+#define POWER_OF_FIVE_MAX 308
+
+// Normalized 128-bit approximations of 5^q for q from POWER_OF_FIVE_MIN to
+// POWER_OF_FIVE_MAX, as high and low words: truncated for q >= 0 and rounded
+// up otherwise.
+static const uint64_t power_of_five_128[] = {
+    0xeef453d6923bd65a, 0x113faa2906a13b3f, 0x9558b4661b6565f8, 0x4ac7ca59a424c507,
+    0xbaaee17fa23ebf76, 0x5d79bcf00d2df649, 0xe95a99df8ace6f53, 0xf4d82c2c107973dc,
+    0x91d8a02bb6c10594, 0x79071b9b8a4be869, 0xb64ec836a47146f9, 0x9748e2826cdee284,
+    0xe3e27a444d8d98b7, 0xfd1b1b2308169b25, 0x8e6d8c6ab0787f72, 0xfe30f0f5e50e20f7,
+    0xb208ef855c969f4f, 0xbdbd2d335e51a935, 0xde8b2b66b3bc4723, 0xad2c788035e61382,
+    0x8b16fb203055ac76, 0x4c3bcb5021afcc31, 0xaddcb9e83c6b1793, 0xdf4abe242a1bbf3d,
+    0xd953e8624b85dd78, 0xd71d6dad34a2af0d, 0x87d4713d6f33aa6b, 0x8672648c40e5ad68,
+    0xa9c98d8ccb009506, 0x680efdaf511f18c2, 0xd43bf0effdc0ba48, 0x0212bd1b2566def2,
+    0x84a57695fe98746d, 0x014bb630f7604b57, 0xa5ced43b7e3e9188, 0x419ea3bd35385e2d,
+    0xcf42894a5dce35ea, 0x52064cac828675b9, 0x818995ce7aa0e1b2, 0x7343efebd1940993,
+    0xa1ebfb4219491a1f, 0x1014ebe6c5f90bf8, 0xca66fa129f9b60a6, 0xd41a26e077774ef6,
+    0xfd00b897478238d0, 0x8920b098955522b4, 0x9e20735e8cb16382, 0x55b46e5f5d5535b0,
+    0xc5a890362fddbc62, 0xeb2189f734aa831d, 0xf712b443bbd52b7b, 0xa5e9ec7501d523e4,
+    0x9a6bb0aa55653b2d, 0x47b233c92125366e, 0xc1069cd4eabe89f8, 0x999ec0bb696e840a,
+    0xf148440a256e2c76, 0xc00670ea43ca250d, 0x96cd2a865764dbca, 0x380406926a5e5728,
+    0xbc807527ed3e12bc, 0xc605083704f5ecf2, 0xeba09271e88d976b, 0xf7864a44c633682e,
+    0x93445b8731587ea3, 0x7ab3ee6afbe0211d, 0xb8157268fdae9e4c, 0x5960ea05bad82964,
+    0xe61acf033d1a45df, 0x6fb92487298e33bd, 0x8fd0c16206306bab, 0xa5d3b6d479f8e056,
+    0xb3c4f1ba87bc8696, 0x8f48a4899877186c, 0xe0b62e2929aba83c, 0x331acdabfe94de87,
+    0x8c71dcd9ba0b4925, 0x9ff0c08b7f1d0b14, 0xaf8e5410288e1b6f, 0x07ecf0ae5ee44dd9,
+    0xdb71e91432b1a24a, 0xc9e82cd9f69d6150, 0x892731ac9faf056e, 0xbe311c083a225cd2,
+    0xab70fe17c79ac6ca, 0x6dbd630a48aaf406, 0xd64d3d9db981787d, 0x092cbbccdad5b108,
+    0x85f0468293f0eb4e, 0x25bbf56008c58ea5, 0xa76c582338ed2621, 0xaf2af2b80af6f24e,
+    0xd1476e2c07286faa, 0x1af5af660db4aee1, 0x82cca4db847945ca, 0x50d98d9fc890ed4d,
+    0xa37fce126597973c, 0xe50ff107bab528a0, 0xcc5fc196fefd7d0c, 0x1e53ed49a96272c8,
+    0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7a, 0x9faacf3df73609b1, 0x77b191618c54e9ac,
+    0xc795830d75038c1d, 0xd59df5b9ef6a2417, 0xf97ae3d0d2446f25, 0x4b0573286b44ad1d,
+    0x9becce62836ac577, 0x4ee367f9430aec32, 0xc2e801fb244576d5, 0x229c41f793cda73f,
+    0xf3a20279ed56d48a, 0x6b43527578c1110f, 0x9845418c345644d6, 0x830a13896b78aaa9,
+    0xbe5691ef416bd60c, 0x23cc986bc656d553, 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa8,
+    0x94b3a202eb1c3f39, 0x7bf7d71432f3d6a9, 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc53,
+    0xe858ad248f5c22c9, 0xd1b3400f8f9cff68, 0x91376c36d99995be, 0x23100809b9c21fa1,
+    0xb58547448ffffb2d, 0xabd40a0c2832a78a, 0xe2e69915b3fff9f9, 0x16c90c8f323f516c,
+    0x8dd01fad907ffc3b, 0xae3da7d97f6792e3, 0xb1442798f49ffb4a, 0x99cd11cfdf41779c,
+    0xdd95317f31c7fa1d, 0x40405643d711d583, 0x8a7d3eef7f1cfc52, 0x482835ea666b2572,
+    0xad1c8eab5ee43b66, 0xda3243650005eecf, 0xd863b256369d4a40, 0x90bed43e40076a82,
+    0x873e4f75e2224e68, 0x5a7744a6e804a291, 0xa90de3535aaae202, 0x711515d0a205cb36,
+    0xd3515c2831559a83, 0x0d5a5b44ca873e03, 0x8412d9991ed58091, 0xe858790afe9486c2,
+    0xa5178fff668ae0b6, 0x626e974dbe39a872, 0xce5d73ff402d98e3, 0xfb0a3d212dc8128f,
+    0x80fa687f881c7f8e, 0x7ce66634bc9d0b99, 0xa139029f6a239f72, 0x1c1fffc1ebc44e80,
+    0xc987434744ac874e, 0xa327ffb266b56220, 0xfbe9141915d7a922, 0x4bf1ff9f0062baa8,
+    0x9d71ac8fada6c9b5, 0x6f773fc3603db4a9, 0xc4ce17b399107c22, 0xcb550fb4384d21d3,
+    0xf6019da07f549b2b, 0x7e2a53a146606a48, 0x99c102844f94e0fb, 0x2eda7444cbfc426d,
+    0xc0314325637a1939, 0xfa911155fefb5308, 0xf03d93eebc589f88, 0x793555ab7eba27ca,
+    0x96267c7535b763b5, 0x4bc1558b2f3458de, 0xbbb01b9283253ca2, 0x9eb1aaedfb016f16,
+    0xea9c227723ee8bcb, 0x465e15a979c1cadc, 0x92a1958a7675175f, 0x0bfacd89ec191ec9,
+    0xb749faed14125d36, 0xcef980ec671f667b, 0xe51c79a85916f484, 0x82b7e12780e7401a,
+    0x8f31cc0937ae58d2, 0xd1b2ecb8b0908810, 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa15,
+    0xdfbdcece67006ac9, 0x67a791e093e1d49a, 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e0,
+    0xaecc49914078536d, 0x58fae9f773886e18, 0xda7f5bf590966848, 0xaf39a475506a899e,
+    0x888f99797a5e012d, 0x6d8406c952429603, 0xaab37fd7d8f58178, 0xc8e5087ba6d33b83,
+    0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a64, 0x855c3be0a17fcd26, 0x5cf2eea09a55067f,
+    0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481e, 0xd0601d8efc57b08b, 0xf13b94daf124da26,
+    0x823c12795db6ce57, 0x76c53d08d6b70858, 0xa2cb1717b52481ed, 0x54768c4b0c64ca6e,
+    0xcb7ddcdda26da268, 0xa9942f5dcf7dfd09, 0xfe5d54150b090b02, 0xd3f93b35435d7c4c,
+    0x9efa548d26e5a6e1, 0xc47bc5014a1a6daf, 0xc6b8e9b0709f109a, 0x359ab6419ca1091b,
+    0xf867241c8cc6d4c0, 0xc30163d203c94b62, 0x9b407691d7fc44f8, 0x79e0de63425dcf1d,
+    0xc21094364dfb5636, 0x985915fc12f542e4, 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939d,
+    0x979cf3ca6cec5b5a, 0xa705992ceecf9c42, 0xbd8430bd08277231, 0x50c6ff782a838353,
+    0xece53cec4a314ebd, 0xa4f8bf5635246428, 0x940f4613ae5ed136, 0x871b7795e136be99,
+    0xb913179899f68584, 0x28e2557b59846e3f, 0xe757dd7ec07426e5, 0x331aeada2fe589cf,
+    0x9096ea6f3848984f, 0x3ff0d2c85def7621, 0xb4bca50b065abe63, 0x0fed077a756b53a9,
+    0xe1ebce4dc7f16dfb, 0xd3e8495912c62894, 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95c,
+    0xb080392cc4349dec, 0xbd8d794d96aacfb3, 0xdca04777f541c567, 0xecf0d7a0fc5583a0,
+    0x89e42caaf9491b60, 0xf41686c49db57244, 0xac5d37d5b79b6239, 0x311c2875c522ced5,
+    0xd77485cb25823ac7, 0x7d633293366b828b, 0x86a8d39ef77164bc, 0xae5dff9c02033197,
+    0xa8530886b54dbdeb, 0xd9f57f830283fdfc, 0xd267caa862a12d66, 0xd072df63c324fd7b,
+    0x8380dea93da4bc60, 0x4247cb9e59f71e6d, 0xa46116538d0deb78, 0x52d9be85f074e608,
+    0xcd795be870516656, 0x67902e276c921f8b, 0x806bd9714632dff6, 0x00ba1cd8a3db53b6,
+    0xa086cfcd97bf97f3, 0x80e8a40eccd228a4, 0xc8a883c0fdaf7df0, 0x6122cd128006b2cd,
+    0xfad2a4b13d1b5d6c, 0x796b805720085f81, 0x9cc3a6eec6311a63, 0xcbe3303674053bb0,
+    0xc3f490aa77bd60fc, 0xbedbfc4411068a9c, 0xf4f1b4d515acb93b, 0xee92fb5515482d44,
+    0x991711052d8bf3c5, 0x751bdd152d4d1c4a, 0xbf5cd54678eef0b6, 0xd262d45a78a0635d,
+    0xef340a98172aace4, 0x86fb897116c87c34, 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da0,
+    0xbae0a846d2195712, 0x8974836059cca109, 0xe998d258869facd7, 0x2bd1a438703fc94b,
+    0x91ff83775423cc06, 0x7b6306a34627ddcf, 0xb67f6455292cbf08, 0x1a3bc84c17b1d542,
+    0xe41f3d6a7377eeca, 0x20caba5f1d9e4a93, 0x8e938662882af53e, 0x547eb47b7282ee9c,
+    0xb23867fb2a35b28d, 0xe99e619a4f23aa43, 0xdec681f9f4c31f31, 0x6405fa00e2ec94d4,
+    0x8b3c113c38f9f37e, 0xde83bc408dd3dd04, 0xae0b158b4738705e, 0x9624ab50b148d445,
+    0xd98ddaee19068c76, 0x3badd624dd9b0957, 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d6,
+    0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4c, 0xd47487cc8470652b, 0x7647c3200069671f,
+    0x84c8d4dfd2c63f3b, 0x29ecd9f40041e073, 0xa5fb0a17c777cf09, 0xf468107100525890,
+    0xcf79cc9db955c2cc, 0x7182148d4066eeb4, 0x81ac1fe293d599bf, 0xc6f14cd848405530,
+    0xa21727db38cb002f, 0xb8ada00e5a506a7c, 0xca9cf1d206fdc03b, 0xa6d90811f0e4851c,
+    0xfd442e4688bd304a, 0x908f4a166d1da663, 0x9e4a9cec15763e2e, 0x9a598e4e043287fe,
+    0xc5dd44271ad3cdba, 0x40eff1e1853f29fd, 0xf7549530e188c128, 0xd12bee59e68ef47c,
+    0x9a94dd3e8cf578b9, 0x82bb74f8301958ce, 0xc13a148e3032d6e7, 0xe36a52363c1faf01,
+    0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac1, 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0b9,
+    0xbcb2b812db11a5de, 0x7415d448f6b6f0e7, 0xebdf661791d60f56, 0x111b495b3464ad21,
+    0x936b9fcebb25c995, 0xcab10dd900beec34, 0xb84687c269ef3bfb, 0x3d5d514f40eea742,
+    0xe65829b3046b0afa, 0x0cb4a5a3112a5112, 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ab,
+    0xb3f4e093db73a093, 0x59ed216765690f56, 0xe0f218b8d25088b8, 0x306869c13ec3532c,
+    0x8c974f7383725573, 0x1e414218c73a13fb, 0xafbd2350644eeacf, 0xe5d1929ef90898fa,
+    0xdbac6c247d62a583, 0xdf45f746b74abf39, 0x894bc396ce5da772, 0x6b8bba8c328eb783,
+    0xab9eb47c81f5114f, 0x066ea92f3f326564, 0xd686619ba27255a2, 0xc80a537b0efefebd,
+    0x8613fd0145877585, 0xbd06742ce95f5f36, 0xa798fc4196e952e7, 0x2c48113823b73704,
+    0xd17f3b51fca3a7a0, 0xf75a15862ca504c5, 0x82ef85133de648c4, 0x9a984d73dbe722fb,
+    0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebba, 0xcc963fee10b7d1b3, 0x318df905079926a8,
+    0xffbbcfe994e5c61f, 0xfdf17746497f7052, 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa633,
+    0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc0, 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b0,
+    0x9c1661a651213e2d, 0x06bea10ca65c084e, 0xc31bfa0fe5698db8, 0x486e494fcff30a62,
+    0xf3e2f893dec3f126, 0x5a89dba3c3efccfa, 0x986ddb5c6b3a76b7, 0xf89629465a75e01c,
+    0xbe89523386091465, 0xf6bbb397f1135823, 0xee2ba6c0678b597f, 0x746aa07ded582e2c,
+    0x94db483840b717ef, 0xa8c2a44eb4571cdc, 0xba121a4650e4ddeb, 0x92f34d62616ce413,
+    0xe896a0d7e51e1566, 0x77b020baf9c81d17, 0x915e2486ef32cd60, 0x0ace1474dc1d122e,
+    0xb5b5ada8aaff80b8, 0x0d819992132456ba, 0xe3231912d5bf60e6, 0x10e1fff697ed6c69,
+    0x8df5efabc5979c8f, 0xca8d3ffa1ef463c1, 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb2,
+    0xddd0467c64bce4a0, 0xac7cb3f6d05ddbde, 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96b,
+    0xad4ab7112eb3929d, 0x86c16c98d2c953c6, 0xd89d64d57a607744, 0xe871c7bf077ba8b7,
+    0x87625f056c7c4a8b, 0x11471cd764ad4972, 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bcf,
+    0xd389b47879823479, 0x4aff1d108d4ec2c3, 0x843610cb4bf160cb, 0xcedf722a585139ba,
+    0xa54394fe1eedb8fe, 0xc2974eb4ee658828, 0xce947a3da6a9273e, 0x733d226229feea32,
+    0x811ccc668829b887, 0x0806357d5a3f525f, 0xa163ff802a3426a8, 0xca07c2dcb0cf26f7,
+    0xc9bcff6034c13052, 0xfc89b393dd02f0b5, 0xfc2c3f3841f17c67, 0xbbac2078d443ace2,
+    0x9d9ba7832936edc0, 0xd54b944b84aa4c0d, 0xc5029163f384a931, 0x0a9e795e65d4df11,
+    0xf64335bcf065d37d, 0x4d4617b5ff4a16d5, 0x99ea0196163fa42e, 0x504bced1bf8e4e45,
+    0xc06481fb9bcf8d39, 0xe45ec2862f71e1d6, 0xf07da27a82c37088, 0x5d767327bb4e5a4c,
+    0x964e858c91ba2655, 0x3a6a07f8d510f86f, 0xbbe226efb628afea, 0x890489f70a55368b,
+    0xeadab0aba3b2dbe5, 0x2b45ac74ccea842e, 0x92c8ae6b464fc96f, 0x3b0b8bc90012929d,
+    0xb77ada0617e3bbcb, 0x09ce6ebb40173744, 0xe55990879ddcaabd, 0xcc420a6a101d0515,
+    0x8f57fa54c2a9eab6, 0x9fa946824a12232d, 0xb32df8e9f3546564, 0x47939822dc96abf9,
+    0xdff9772470297ebd, 0x59787e2b93bc56f7, 0x8bfbea76c619ef36, 0x57eb4edb3c55b65a,
+    0xaefae51477a06b03, 0xede622920b6b23f1, 0xdab99e59958885c4, 0xe95fab368e45eced,
+    0x88b402f7fd75539b, 0x11dbcb0218ebb414, 0xaae103b5fcd2a881, 0xd652bdc29f26a119,
+    0xd59944a37c0752a2, 0x4be76d3346f0495f, 0x857fcae62d8493a5, 0x6f70a4400c562ddb,
+    0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb952, 0xd097ad07a71f26b2, 0x7e2000a41346a7a7,
+    0x825ecc24c873782f, 0x8ed400668c0c28c8, 0xa2f67f2dfa90563b, 0x728900802f0f32fa,
+    0xcbb41ef979346bca, 0x4f2b40a03ad2ffb9, 0xfea126b7d78186bc, 0xe2f610c84987bfa8,
+    0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7c9, 0xc6ede63fa05d3143, 0x91503d1c79720dbb,
+    0xf8a95fcf88747d94, 0x75a44c6397ce912a, 0x9b69dbe1b548ce7c, 0xc986afbe3ee11aba,
+    0xc24452da229b021b, 0xfbe85badce996168, 0xf2d56790ab41c2a2, 0xfae27299423fb9c3,
+    0x97c560ba6b0919a5, 0xdccd879fc967d41a, 0xbdb6b8e905cb600f, 0x5400e987bbc1c920,
+    0xed246723473e3813, 0x290123e9aab23b68, 0x9436c0760c86e30b, 0xf9a0b6720aaf6521,
+    0xb94470938fa89bce, 0xf808e40e8d5b3e69, 0xe7958cb87392c2c2, 0xb60b1d1230b20e04,
+    0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c2, 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af3,
+    0xe2280b6c20dd5232, 0x25c6da63c38de1b0, 0x8d590723948a535f, 0x579c487e5a38ad0e,
+    0xb0af48ec79ace837, 0x2d835a9df0c6d851, 0xdcdb1b2798182244, 0xf8e431456cf88e65,
+    0x8a08f0f8bf0f156b, 0x1b8e9ecb641b58ff, 0xac8b2d36eed2dac5, 0xe272467e3d222f3f,
+    0xd7adf884aa879177, 0x5b0ed81dcc6abb0f, 0x86ccbb52ea94baea, 0x98e947129fc2b4e9,
+    0xa87fea27a539e9a5, 0x3f2398d747b36224, 0xd29fe4b18e88640e, 0x8eec7f0d19a03aad,
+    0x83a3eeeef9153e89, 0x1953cf68300424ac, 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd7,
+    0xcdb02555653131b6, 0x3792f412cb06794d, 0x808e17555f3ebf11, 0xe2bbd88bbee40bd0,
+    0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec4, 0xc8de047564d20a8b, 0xf245825a5a445275,
+    0xfb158592be068d2e, 0xeed6e2f0f0d56712, 0x9ced737bb6c4183d, 0x55464dd69685606b,
+    0xc428d05aa4751e4c, 0xaa97e14c3c26b886, 0xf53304714d9265df, 0xd53dd99f4b3066a8,
+    0x993fe2c6d07b7fab, 0xe546a8038efe4029, 0xbf8fdb78849a5f96, 0xde98520472bdd033,
+    0xef73d256a5c0f77c, 0x963e66858f6d4440, 0x95a8637627989aad, 0xdde7001379a44aa8,
+    0xbb127c53b17ec159, 0x5560c018580d5d52, 0xe9d71b689dde71af, 0xaab8f01e6e10b4a6,
+    0x9226712162ab070d, 0xcab3961304ca70e8, 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d22,
+    0xe45c10c42a2b3b05, 0x8cb89a7db77c506a, 0x8eb98a7a9a5b04e3, 0x77f3608e92adb242,
+    0xb267ed1940f1c61c, 0x55f038b237591ed3, 0xdf01e85f912e37a3, 0x6b6c46dec52f6688,
+    0x8b61313bbabce2c6, 0x2323ac4b3b3da015, 0xae397d8aa96c1b77, 0xabec975e0a0d081a,
+    0xd9c7dced53c72255, 0x96e7bd358c904a21, 0x881cea14545c7575, 0x7e50d64177da2e54,
+    0xaa242499697392d2, 0xdde50bd1d5d0b9e9, 0xd4ad2dbfc3d07787, 0x955e4ec64b44e864,
+    0x84ec3c97da624ab4, 0xbd5af13bef0b113e, 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58e,
+    0xcfb11ead453994ba, 0x67de18eda5814af2, 0x81ceb32c4b43fcf4, 0x80eacf948770ced7,
+    0xa2425ff75e14fc31, 0xa1258379a94d028d, 0xcad2f7f5359a3b3e, 0x096ee45813a04330,
+    0xfd87b5f28300ca0d, 0x8bca9d6e188853fc, 0x9e74d1b791e07e48, 0x775ea264cf55347e,
+    0xc612062576589dda, 0x95364afe032a819e, 0xf79687aed3eec551, 0x3a83ddbd83f52205,
+    0x9abe14cd44753b52, 0xc4926a9672793543, 0xc16d9a0095928a27, 0x75b7053c0f178294,
+    0xf1c90080baf72cb1, 0x5324c68b12dd6339, 0x971da05074da7bee, 0xd3f6fc16ebca5e04,
+    0xbce5086492111aea, 0x88f4bb1ca6bcf585, 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6,
+    0x9392ee8e921d5d07, 0x3aff322e62439fd0, 0xb877aa3236a4b449, 0x09befeb9fad487c3,
+    0xe69594bec44de15b, 0x4c2ebe687989a9b4, 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11,
+    0xb424dc35095cd80f, 0x538484c19ef38c95, 0xe12e13424bb40e13, 0x2865a5f206b06fba,
+    0x8cbccc096f5088cb, 0xf93f87b7442e45d4, 0xafebff0bcb24aafe, 0xf78f69a51539d749,
+    0xdbe6fecebdedd5be, 0xb573440e5a884d1c, 0x89705f4136b4a597, 0x31680a88f8953031,
+    0xabcc77118461cefc, 0xfdc20d2b36ba7c3e, 0xd6bf94d5e57a42bc, 0x3d32907604691b4d,
+    0x8637bd05af6c69b5, 0xa63f9a49c2c1b110, 0xa7c5ac471b478423, 0x0fcf80dc33721d54,
+    0xd1b71758e219652b, 0xd3c36113404ea4a9, 0x83126e978d4fdf3b, 0x645a1cac083126ea,
+    0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4, 0xcccccccccccccccc, 0xcccccccccccccccd,
+    0x8000000000000000, 0x0000000000000000, 0xa000000000000000, 0x0000000000000000,
+    0xc800000000000000, 0x0000000000000000, 0xfa00000000000000, 0x0000000000000000,
+    0x9c40000000000000, 0x0000000000000000, 0xc350000000000000, 0x0000000000000000,
+    0xf424000000000000, 0x0000000000000000, 0x9896800000000000, 0x0000000000000000,
+    0xbebc200000000000, 0x0000000000000000, 0xee6b280000000000, 0x0000000000000000,
+    0x9502f90000000000, 0x0000000000000000, 0xba43b74000000000, 0x0000000000000000,
+    0xe8d4a51000000000, 0x0000000000000000, 0x9184e72a00000000, 0x0000000000000000,
+    0xb5e620f480000000, 0x0000000000000000, 0xe35fa931a0000000, 0x0000000000000000,
+    0x8e1bc9bf04000000, 0x0000000000000000, 0xb1a2bc2ec5000000, 0x0000000000000000,
+    0xde0b6b3a76400000, 0x0000000000000000, 0x8ac7230489e80000, 0x0000000000000000,
+    0xad78ebc5ac620000, 0x0000000000000000, 0xd8d726b7177a8000, 0x0000000000000000,
+    0x878678326eac9000, 0x0000000000000000, 0xa968163f0a57b400, 0x0000000000000000,
+    0xd3c21bcecceda100, 0x0000000000000000, 0x84595161401484a0, 0x0000000000000000,
+    0xa56fa5b99019a5c8, 0x0000000000000000, 0xcecb8f27f4200f3a, 0x0000000000000000,
+    0x813f3978f8940984, 0x4000000000000000, 0xa18f07d736b90be5, 0x5000000000000000,
+    0xc9f2c9cd04674ede, 0xa400000000000000, 0xfc6f7c4045812296, 0x4d00000000000000,
+    0x9dc5ada82b70b59d, 0xf020000000000000, 0xc5371912364ce305, 0x6c28000000000000,
+    0xf684df56c3e01bc6, 0xc732000000000000, 0x9a130b963a6c115c, 0x3c7f400000000000,
+    0xc097ce7bc90715b3, 0x4b9f100000000000, 0xf0bdc21abb48db20, 0x1e86d40000000000,
+    0x96769950b50d88f4, 0x1314448000000000, 0xbc143fa4e250eb31, 0x17d955a000000000,
+    0xeb194f8e1ae525fd, 0x5dcfab0800000000, 0x92efd1b8d0cf37be, 0x5aa1cae500000000,
+    0xb7abc627050305ad, 0xf14a3d9e40000000, 0xe596b7b0c643c719, 0x6d9ccd05d0000000,
+    0x8f7e32ce7bea5c6f, 0xe4820023a2000000, 0xb35dbf821ae4f38b, 0xdda2802c8a800000,
+    0xe0352f62a19e306e, 0xd50b2037ad200000, 0x8c213d9da502de45, 0x4526f422cc340000,
+    0xaf298d050e4395d6, 0x9670b12b7f410000, 0xdaf3f04651d47b4c, 0x3c0cdd765f114000,
+    0x88d8762bf324cd0f, 0xa5880a69fb6ac800, 0xab0e93b6efee0053, 0x8eea0d047a457a00,
+    0xd5d238a4abe98068, 0x72a4904598d6d880, 0x85a36366eb71f041, 0x47a6da2b7f864750,
+    0xa70c3c40a64e6c51, 0x999090b65f67d924, 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6d,
+    0x82818f1281ed449f, 0xbff8f10e7a8921a4, 0xa321f2d7226895c7, 0xaff72d52192b6a0d,
+    0xcbea6f8ceb02bb39, 0x9bf4f8a69f764490, 0xfee50b7025c36a08, 0x02f236d04753d5b4,
+    0x9f4f2726179a2245, 0x01d762422c946590, 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef5,
+    0xf8ebad2b84e0d58b, 0xd2e0898765a7deb2, 0x9b934c3b330c8577, 0x63cc55f49f88eb2f,
+    0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fb, 0xf316271c7fc3908a, 0x8bef464e3945ef7a,
+    0x97edd871cfda3a56, 0x97758bf0e3cbb5ac, 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea317,
+    0xed63a231d4c4fb27, 0x4ca7aaa863ee4bdd, 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6a,
+    0xb975d6b6ee39e436, 0xb3e2fd538e122b44, 0xe7d34c64a9c85d44, 0x60dbbca87196b616,
+    0x90e40fbeea1d3a4a, 0xbc8955e946fe31cd, 0xb51d13aea4a488dd, 0x6babab6398bdbe41,
+    0xe264589a4dcdab14, 0xc696963c7eed2dd1, 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca2,
+    0xb0de65388cc8ada8, 0x3b25a55f43294bcb, 0xdd15fe86affad912, 0x49ef0eb713f39ebe,
+    0x8a2dbf142dfcc7ab, 0x6e3569326c784337, 0xacb92ed9397bf996, 0x49c2c37f07965404,
+    0xd7e77a8f87daf7fb, 0xdc33745ec97be906, 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a3,
+    0xa8acd7c0222311bc, 0xc40832ea0d68ce0c, 0xd2d80db02aabd62b, 0xf50a3fa490c30190,
+    0x83c7088e1aab65db, 0x792667c6da79e0fa, 0xa4b8cab1a1563f52, 0x577001b891185938,
+    0xcde6fd5e09abcf26, 0xed4c0226b55e6f86, 0x80b05e5ac60b6178, 0x544f8158315b05b4,
+    0xa0dc75f1778e39d6, 0x696361ae3db1c721, 0xc913936dd571c84c, 0x03bc3a19cd1e38e9,
+    0xfb5878494ace3a5f, 0x04ab48a04065c723, 0x9d174b2dcec0e47b, 0x62eb0d64283f9c76,
+    0xc45d1df942711d9a, 0x3ba5d0bd324f8394, 0xf5746577930d6500, 0xca8f44ec7ee36479,
+    0x9968bf6abbe85f20, 0x7e998b13cf4e1ecb, 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67e,
+    0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101e, 0x95d04aee3b80ece5, 0xbba1f1d158724a12,
+    0xbb445da9ca61281f, 0x2a8a6e45ae8edc97, 0xea1575143cf97226, 0xf52d09d71a3293bd,
+    0x924d692ca61be758, 0x593c2626705f9c56, 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836c,
+    0xe498f455c38b997a, 0x0b6dfb9c0f956447, 0x8edf98b59a373fec, 0x4724bd4189bd5eac,
+    0xb2977ee300c50fe7, 0x58edec91ec2cb657, 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ed,
+    0x8b865b215899f46c, 0xbd79e0d20082ee74, 0xae67f1e9aec07187, 0xecd8590680a3aa11,
+    0xda01ee641a708de9, 0xe80e6f4820cc9495, 0x884134fe908658b2, 0x3109058d147fdcdd,
+    0xaa51823e34a7eede, 0xbd4b46f0599fd415, 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91a,
+    0x850fadc09923329e, 0x03e2cf6bc604ddb0, 0xa6539930bf6bff45, 0x84db8346b786151c,
+    0xcfe87f7cef46ff16, 0xe612641865679a63, 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07e,
+    0xa26da3999aef7749, 0xe3be5e330f38f09d, 0xcb090c8001ab551c, 0x5cadf5bfd3072cc5,
+    0xfdcb4fa002162a63, 0x73d9732fc7c8f7f6, 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afa,
+    0xc646d63501a1511d, 0xb281e1fd541501b8, 0xf7d88bc24209a565, 0x1f225a7ca91a4226,
+    0x9ae757596946075f, 0x3375788de9b06958, 0xc1a12d2fc3978937, 0x0052d6b1641c83ae,
+    0xf209787bb47d6b84, 0xc0678c5dbd23a49a, 0x9745eb4d50ce6332, 0xf840b7ba963646e0,
+    0xbd176620a501fbff, 0xb650e5a93bc3d898, 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebe,
+    0x93ba47c980e98cdf, 0xc66f336c36b10137, 0xb8a8d9bbe123f017, 0xb80b0047445d4184,
+    0xe6d3102ad96cec1d, 0xa60dc059157491e5, 0x9043ea1ac7e41392, 0x87c89837ad68db2f,
+    0xb454e4a179dd1877, 0x29babe4598c311fb, 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67a,
+    0x8ce2529e2734bb1d, 0x1899e4a65f58660c, 0xb01ae745b101e9e4, 0x5ec05dcff72e7f8f,
+    0xdc21a1171d42645d, 0x76707543f4fa1f73, 0x899504ae72497eba, 0x6a06494a791c53a8,
+    0xabfa45da0edbde69, 0x0487db9d17636892, 0xd6f8d7509292d603, 0x45a9d2845d3c42b6,
+    0x865b86925b9bc5c2, 0x0b8a2392ba45a9b2, 0xa7f26836f282b732, 0x8e6cac7768d7141e,
+    0xd1ef0244af2364ff, 0x3207d795430cd926, 0x8335616aed761f1f, 0x7f44e6bd49e807b8,
+    0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a6, 0xcd036837130890a1, 0x36dba887c37a8c0f,
+    0x802221226be55a64, 0xc2494954da2c9789, 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6c,
+    0xc83553c5c8965d3d, 0x6f92829494e5acc7, 0xfa42a8b73abbf48c, 0xcb772339ba1f17f9,
+    0x9c69a97284b578d7, 0xff2a760414536efb, 0xc38413cf25e2d70d, 0xfef5138519684aba,
+    0xf46518c2ef5b8cd1, 0x7eb258665fc25d69, 0x98bf2f79d5993802, 0xef2f773ffbd97a61,
+    0xbeeefb584aff8603, 0xaafb550ffacfd8fa, 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf38,
+    0x952ab45cfa97a0b2, 0xdd945a747bf26183, 0xba756174393d88df, 0x94f971119aeef9e4,
+    0xe912b9d1478ceb17, 0x7a37cd5601aab85d, 0x91abb422ccb812ee, 0xac62e055c10ab33a,
+    0xb616a12b7fe617aa, 0x577b986b314d6009, 0xe39c49765fdf9d94, 0xed5a7e85fda0b80b,
+    0x8e41ade9fbebc27d, 0x14588f13be847307, 0xb1d219647ae6b31c, 0x596eb2d8ae258fc8,
+    0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bb, 0x8aec23d680043bee, 0x25de7bb9480d5854,
+    0xada72ccc20054ae9, 0xaf561aa79a10ae6a, 0xd910f7ff28069da4, 0x1b2ba1518094da04,
+    0x87aa9aff79042286, 0x90fb44d2f05d0842, 0xa99541bf57452b28, 0x353a1607ac744a53,
+    0xd3fa922f2d1675f2, 0x42889b8997915ce8, 0x847c9b5d7c2e09b7, 0x69956135febada11,
+    0xa59bc234db398c25, 0x43fab9837e699095, 0xcf02b2c21207ef2e, 0x94f967e45e03f4bb,
+    0x8161afb94b44f57d, 0x1d1be0eebac278f5, 0xa1ba1ba79e1632dc, 0x6462d92a69731732,
+    0xca28a291859bbf93, 0x7d7b8f7503cfdcfe, 0xfcb2cb35e702af78, 0x5cda735244c3d43e,
+    0x9defbf01b061adab, 0x3a0888136afa64a7, 0xc56baec21c7a1916, 0x088aaa1845b8fdd0,
+    0xf6c69a72a3989f5b, 0x8aad549e57273d45, 0x9a3c2087a63f6399, 0x36ac54e2f678864b,
+    0xc0cb28a98fcf3c7f, 0x84576a1bb416a7dd, 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d5,
+    0x969eb7c47859e743, 0x9f644ae5a4b1b325, 0xbc4665b596706114, 0x873d5d9f0dde1fee,
+    0xeb57ff22fc0c7959, 0xa90cb506d155a7ea, 0x9316ff75dd87cbd8, 0x09a7f12442d588f2,
+    0xb7dcbf5354e9bece, 0x0c11ed6d538aeb2f, 0xe5d3ef282a242e81, 0x8f1668c8a86da5fa,
+    0x8fa475791a569d10, 0xf96e017d694487bc, 0xb38d92d760ec4455, 0x37c981dcc395a9ac,
+    0xe070f78d3927556a, 0x85bbe253f47b1417, 0x8c469ab843b89562, 0x93956d7478ccec8e,
+    0xaf58416654a6babb, 0x387ac8d1970027b2, 0xdb2e51bfe9d0696a, 0x06997b05fcc0319e,
+    0x88fcf317f22241e2, 0x441fece3bdf81f03, 0xab3c2fddeeaad25a, 0xd527e81cad7626c3,
+    0xd60b3bd56a5586f1, 0x8a71e223d8d3b074, 0x85c7056562757456, 0xf6872d5667844e49,
+    0xa738c6bebb12d16c, 0xb428f8ac016561db, 0xd106f86e69d785c7, 0xe13336d701beba52,
+    0x82a45b450226b39c, 0xecc0024661173473, 0xa34d721642b06084, 0x27f002d7f95d0190,
+    0xcc20ce9bd35c78a5, 0x31ec038df7b441f4, 0xff290242c83396ce, 0x7e67047175a15271,
+    0x9f79a169bd203e41, 0x0f0062c6e984d386, 0xc75809c42c684dd1, 0x52c07b78a3e60868,
+    0xf92e0c3537826145, 0xa7709a56ccdf8a82, 0x9bbcc7a142b17ccb, 0x88a66076400bb691,
+    0xc2abf989935ddbfe, 0x6acff893d00ea435, 0xf356f7ebf83552fe, 0x0583f6b8c4124d43,
+    0x98165af37b2153de, 0xc3727a337a8b704a, 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5c,
+    0xeda2ee1c7064130c, 0x1162def06f79df73, 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba8,
+    0xb9a74a0637ce2ee1, 0x6d953e2bd7173692, 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0437,
+    0x910ab1d4db9914a0, 0x1d9c9892400a22a2, 0xb54d5e4a127f59c8, 0x2503beb6d00cab4b,
+    0xe2a0b5dc971f303a, 0x2e44ae64840fd61d, 0x8da471a9de737e24, 0x5ceaecfed289e5d2,
+    0xb10d8e1456105dad, 0x7425a83e872c5f47, 0xdd50f1996b947518, 0xd12f124e28f77719,
+    0x8a5296ffe33cc92f, 0x82bd6b70d99aaa6f, 0xace73cbfdc0bfb7b, 0x636cc64d1001550b,
+    0xd8210befd30efa5a, 0x3c47f7e05401aa4e, 0x8714a775e3e95c78, 0x65acfaec34810a71,
+    0xa8d9d1535ce3b396, 0x7f1839a741a14d0d, 0xd31045a8341ca07c, 0x1ede48111209a050,
+    0x83ea2b892091e44d, 0x934aed0aab460432, 0xa4e4b66b68b65d60, 0xf81da84d5617853f,
+    0xce1de40642e3f4b9, 0x36251260ab9d668e, 0x80d2ae83e9ce78f3, 0xc1d72b7c6b426019,
+    0xa1075a24e4421730, 0xb24cf65b8612f81f, 0xc94930ae1d529cfc, 0xdee033f26797b627,
+    0xfb9b7cd9a4a7443c, 0x169840ef017da3b1, 0x9d412e0806e88aa5, 0x8e1f289560ee864e,
+    0xc491798a08a2ad4e, 0xf1a6f2bab92a27e2, 0xf5b5d7ec8acb58a2, 0xae10af696774b1db,
+    0x9991a6f3d6bf1765, 0xacca6da1e0a8ef29, 0xbff610b0cc6edd3f, 0x17fd090a58d32af3,
+    0xeff394dcff8a948e, 0xddfc4b4cef07f5b0, 0x95f83d0a1fb69cd9, 0x4abdaf101564f98e,
+    0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f1, 0xea53df5fd18d5513, 0x84c86189216dc5ed,
+    0x92746b9be2f8552c, 0x32fd3cf5b4e49bb4, 0xb7118682dbb66a77, 0x3fbc8c33221dc2a1,
+    0xe4d5e82392a40515, 0x0fabaf3feaa5334a, 0x8f05b1163ba6832d, 0x29cb4d87f2a7400e,
+    0xb2c71d5bca9023f8, 0x743e20e9ef511012, 0xdf78e4b2bd342cf6, 0x914da9246b255416,
+    0x8bab8eefb6409c1a, 0x1ad089b6c2f7548e, 0xae9672aba3d0c320, 0xa184ac2473b529b1,
+    0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741e, 0x8865899617fb1871, 0x7e2fa67c7a658892,
+    0xaa7eebfb9df9de8d, 0xddbb901b98feeab7, 0xd51ea6fa85785631, 0x552a74227f3ea565,
+    0x8533285c936b35de, 0xd53a88958f87275f, 0xa67ff273b8460356, 0x8a892abaf368f137,
+    0xd01fef10a657842c, 0x2d2b7569b0432d85, 0x8213f56a67f6b29b, 0x9c3b29620e29fc73,
+    0xa298f2c501f45f42, 0x8349f3ba91b47b8f, 0xcb3f2f7642717713, 0x241c70a936219a73,
+    0xfe0efb53d30dd4d7, 0xed238cd383aa0110, 0x9ec95d1463e8a506, 0xf4363804324a40aa,
+    0xc67bb4597ce2ce48, 0xb143c6053edcd0d5, 0xf81aa16fdc1b81da, 0xdd94b7868e94050a,
+    0x9b10a4e5e9913128, 0xca7cf2b4191c8326, 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f0,
+    0xf24a01a73cf2dccf, 0xbc633b39673c8cec, 0x976e41088617ca01, 0xd5be0503e085d813,
+    0xbd49d14aa79dbc82, 0x4b2d8644d8a74e18, 0xec9c459d51852ba2, 0xddf8e7d60ed1219e,
+    0x93e1ab8252f33b45, 0xcabb90e5c942b503, 0xb8da1662e7b00a17, 0x3d6a751f3b936243,
+    0xe7109bfba19c0c9d, 0x0cc512670a783ad4, 0x906a617d450187e2, 0x27fb2b80668b24c5,
+    0xb484f9dc9641e9da, 0xb1f9f660802dedf6, 0xe1a63853bbd26451, 0x5e7873f8a0396973,
+    0x8d07e33455637eb2, 0xdb0b487b6423e1e8, 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda62,
+    0xdc5c5301c56b75f7, 0x7641a140cc7810fb, 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9d,
+    0xac2820d9623bf429, 0x546345fa9fbdcd44, 0xd732290fbacaf133, 0xa97c177947ad4095,
+    0x867f59a9d4bed6c0, 0x49ed8eabcccc485d, 0xa81f301449ee8c70, 0x5c68f256bfff5a74,
+    0xd226fc195c6a2f8c, 0x73832eec6fff3111, 0x83585d8fd9c25db7, 0xc831fd53c5ff7eab,
+    0xa42e74f3d032f525, 0xba3e7ca8b77f5e55, 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35eb,
+    0x80444b5e7aa7cf85, 0x7980d163cf5b81b3, 0xa0555e361951c366, 0xd7e105bcc332621f,
+    0xc86ab5c39fa63440, 0x8dd9472bf3fefaa7, 0xfa856334878fc150, 0xb14f98f6f0feb951,
+    0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d3, 0xc3b8358109e84f07, 0x0a862f80ec4700c8,
+    0xf4a642e14c6262c8, 0xcd27bb612758c0fa, 0x98e7e9cccfbd7dbd, 0x8038d51cb897789c,
+    0xbf21e44003acdd2c, 0xe0470a63e6bd56c3, 0xeeea5d5004981478, 0x1858ccfce06cac74,
+    0x95527a5202df0ccb, 0x0f37801e0c43ebc8, 0xbaa718e68396cffd, 0xd30560258f54e6ba,
+    0xe950df20247c83fd, 0x47c6b82ef32a2069, 0x91d28b7416cdd27e, 0x4cdc331d57fa5441,
+    0xb6472e511c81471d, 0xe0133fe4adf8e952, 0xe3d8f9e563a198e5, 0x58180fddd97723a6,
+    0x8e679c2f5e44ff8f, 0x570f09eaa7ea7648,
+};
+
+static const double exact_powers_of_ten[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static void multiply_64(uint64_t first, uint64_t second, uint64_t *high, uint64_t *low) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)first * second;
+    *high = (uint64_t)(product >> 64);
+    *low = (uint64_t)product;
+#else
+    uint64_t first_low = (uint32_t)first, first_high = first >> 32;
+    uint64_t second_low = (uint32_t)second, second_high = second >> 32;
+    uint64_t low_low = first_low * second_low;
+    uint64_t high_low = first_high * second_low;
+    uint64_t low_high = first_low * second_high;
+    uint64_t middle = (low_low >> 32) + (uint32_t)high_low + (uint32_t)low_high;
+    *low = (middle << 32) | (uint32_t)low_low;
+    *high = first_high * second_high + (high_low >> 32) + (low_high >> 32) + (middle >> 32);
+#endif
+}
+
+// Bits of the double nearest to digits * 10^power_of_ten, for digits > 0.
+static uint64_t eisel_lemire(int64_t power_of_ten, uint64_t digits) {
+    if (power_of_ten < POWER_OF_FIVE_MIN) {
+        return 0;
+    }
+    if (power_of_ten > POWER_OF_FIVE_MAX) {
+        return 0x7FFULL << 52;
+    }
+    int32_t leading_zeros = __builtin_clzll(digits);
+    digits <<= leading_zeros;
+
+    // The top 55 bits of the product decide the rounding; the second half of
+    // the power of five is only needed when the first leaves them uncertain.
+    int32_t index = 2 * (int32_t)(power_of_ten - POWER_OF_FIVE_MIN);
+    uint64_t high, low;
+    multiply_64(digits, power_of_five_128[index], &high, &low);
+    if ((high & 0x1FF) == 0x1FF) {
+        uint64_t second_high, second_low;
+        multiply_64(digits, power_of_five_128[index + 1], &second_high, &second_low);
+        low += second_high;
+        if (second_high > low) {
+            high++;
+        }
+    }
+
+    int32_t upper_bit = (int32_t)(high >> 63);
+    int32_t shift = upper_bit + 64 - 52 - 3;
+    uint64_t mantissa = high >> shift;
+    int32_t power_of_two = (int32_t)((((152170 + 65536) * power_of_ten) >> 16) + 63)
+        + upper_bit - leading_zeros + 1023;
+    if (power_of_two <= 0) {
+        // Subnormal, or zero when more than 64 bits fall below the smallest.
+        if (-power_of_two + 1 >= 64) {
+            return 0;
+        }
+        mantissa >>= -power_of_two + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power_of_two = mantissa < (1ULL << 52) ? 0 : 1;
+        return ((uint64_t)power_of_two << 52) | (mantissa & ((1ULL << 52) - 1));
+    }
+    // Ties go to even: a product exactly halfway between two doubles, which
+    // is only possible for small powers of ten, rounds down from an odd
+    // mantissa bit instead of up.
+    if (low <= 1 && power_of_ten >= -4 && power_of_ten <= 23 && (mantissa & 3) == 1
+        && (mantissa << shift) == high) {
+        mantissa &= ~1ULL;
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (2ULL << 52)) {
+        mantissa = 1ULL << 52;
+        power_of_two++;
+    }
+    mantissa &= ~(1ULL << 52);
+    if (power_of_two >= 0x7FF) {
+        return 0x7FFULL << 52;
+    }
+    return ((uint64_t)power_of_two << 52) | mantissa;
+}
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Scans [-]digits[.digits][(e|E)[+|-]digits] from text, which starts with a
+// digit, '.' or '-' and a digit, accepting the same decimal forms as strtod.
+// Returns false, leaving *end_ptr alone, if there are no digits.
+static bool scan_number(const char *text, double *number, const char **end_ptr) {
+    const char *p = text;
+    bool negative = *p == '-';
+    p += negative;
+    const char *integer_start = p;
+    uint64_t digits = 0;
+    while (is_digit(*p)) {
+        digits = digits * 10 + (uint64_t)(*p - '0');
+        p++;
+    }
+    const char *integer_end = p;
+    int64_t digit_count = integer_end - integer_start;
+    int64_t power_of_ten = 0;
+    const char *fraction_start = NULL;
+    if (*p == '.') {
+        p++;
+        fraction_start = p;
+        while (is_digit(*p)) {
+            digits = digits * 10 + (uint64_t)(*p - '0');
+            p++;
+        }
+        power_of_ten = fraction_start - p;
+        digit_count -= power_of_ten;
+    }
+    if (digit_count == 0) {
+        return false;
+    }
+    int64_t explicit_exponent = 0;
+    if ((*p == 'e' || *p == 'E')
+        && (is_digit(p[1]) || ((p[1] == '+' || p[1] == '-') && is_digit(p[2])))) {
+        p++;
+        bool negative_exponent = *p == '-';
+        p += *p == '+' || *p == '-';
+        while (is_digit(*p)) {
+            if (explicit_exponent < 0x10000000) {
+                explicit_exponent = explicit_exponent * 10 + (*p - '0');
+            }
+            p++;
+        }
+        if (negative_exponent) {
+            explicit_exponent = -explicit_exponent;
+        }
+    }
+    power_of_ten += explicit_exponent;
+    *end_ptr = p;
+
+    // Past 19 significant digits the accumulator has overflowed: keep the
+    // first 19 and note that the value lies below the next 19-digit number.
+    bool truncated = false;
+    if (digit_count > 19) {
+        for (const char *c = integer_start; *c == '0' || *c == '.'; c++) {
+            digit_count -= *c == '0';
+        }
+        if (digit_count > 19) {
+            truncated = true;
+            const uint64_t nineteen_digits = 1000000000000000000ULL;
+            digits = 0;
+            const char *c = integer_start;
+            while (digits < nineteen_digits && c != integer_end) {
+                digits = digits * 10 + (uint64_t)(*c++ - '0');
+            }
+            if (digits >= nineteen_digits) {
+                power_of_ten = (integer_end - c) + explicit_exponent;
+            } else {
+                c = fraction_start;
+                while (digits < nineteen_digits && c != NULL && is_digit(*c)) {
+                    digits = digits * 10 + (uint64_t)(*c++ - '0');
+                }
+                power_of_ten = (fraction_start - c) + explicit_exponent;
+            }
+        }
+    }
+
+    double value;
+    if (!truncated && digits <= (1ULL << 53) && power_of_ten >= -22 && power_of_ten <= 22) {
+        value = (double)digits;
+        value = power_of_ten < 0 ? value / exact_powers_of_ten[-power_of_ten]
+            : value * exact_powers_of_ten[power_of_ten];
+    } else if (digits == 0) {
+        value = 0.0;
+    } else {
+        uint64_t bits = eisel_lemire(power_of_ten, digits);
+        if (truncated && eisel_lemire(power_of_ten, digits + 1) != bits) {
+            *number = strtod(text, NULL);
+            return true;
+        }
+        memcpy(&value, &bits, sizeof(value));
+    }
+    *number = negative ? -value : value;
+    return true;
+}
+
+// Number Formatting
+// Numbers print as the shortest decimal that reads back as the same double,
+// found with the Schubfach algorithm: the bounds of the interval of decimals
+// that round to the number are scaled by a 128-bit approximation of a power
+// of ten, chosen so that the candidates with the fewest digits become
+// integers, and the candidate nearest the number wins. Integers below 2^53
+// skip all of it. The decimal is written without an exponent between 1e-7
+// and 1e21 and with one elsewhere, as JavaScript does.
+#define POWER_OF_TEN_MIN (-292)
+#define POWER_OF_TEN_MAX 326
+
+// 128-bit approximations of 10^k for k from POWER_OF_TEN_MIN to
+// POWER_OF_TEN_MAX, as high and low words: floor(10^k / 2^e) + 1 with e
+// chosen so that the high word's top bit is set.
+static const uint64_t power_of_ten_128[] = {
+    0xff77b1fcbebcdc4f, 0x25e8e89c13bb0f7b, 0x9faacf3df73609b1, 0x77b191618c54e9ad,
+    0xc795830d75038c1d, 0xd59df5b9ef6a2418, 0xf97ae3d0d2446f25, 0x4b0573286b44ad1e,
+    0x9becce62836ac577, 0x4ee367f9430aec33, 0xc2e801fb244576d5, 0x229c41f793cda740,
+    0xf3a20279ed56d48a, 0x6b43527578c11110, 0x9845418c345644d6, 0x830a13896b78aaaa,
+    0xbe5691ef416bd60c, 0x23cc986bc656d554, 0xedec366b11c6cb8f, 0x2cbfbe86b7ec8aa9,
+    0x94b3a202eb1c3f39, 0x7bf7d71432f3d6aa, 0xb9e08a83a5e34f07, 0xdaf5ccd93fb0cc54,
+    0xe858ad248f5c22c9, 0xd1b3400f8f9cff69, 0x91376c36d99995be, 0x23100809b9c21fa2,
+    0xb58547448ffffb2d, 0xabd40a0c2832a78b, 0xe2e69915b3fff9f9, 0x16c90c8f323f516d,
+    0x8dd01fad907ffc3b, 0xae3da7d97f6792e4, 0xb1442798f49ffb4a, 0x99cd11cfdf41779d,
+    0xdd95317f31c7fa1d, 0x40405643d711d584, 0x8a7d3eef7f1cfc52, 0x482835ea666b2573,
+    0xad1c8eab5ee43b66, 0xda3243650005eed0, 0xd863b256369d4a40, 0x90bed43e40076a83,
+    0x873e4f75e2224e68, 0x5a7744a6e804a292, 0xa90de3535aaae202, 0x711515d0a205cb37,
+    0xd3515c2831559a83, 0x0d5a5b44ca873e04, 0x8412d9991ed58091, 0xe858790afe9486c3,
+    0xa5178fff668ae0b6, 0x626e974dbe39a873, 0xce5d73ff402d98e3, 0xfb0a3d212dc81290,
+    0x80fa687f881c7f8e, 0x7ce66634bc9d0b9a, 0xa139029f6a239f72, 0x1c1fffc1ebc44e81,
+    0xc987434744ac874e, 0xa327ffb266b56221, 0xfbe9141915d7a922, 0x4bf1ff9f0062baa9,
+    0x9d71ac8fada6c9b5, 0x6f773fc3603db4aa, 0xc4ce17b399107c22, 0xcb550fb4384d21d4,
+    0xf6019da07f549b2b, 0x7e2a53a146606a49, 0x99c102844f94e0fb, 0x2eda7444cbfc426e,
+    0xc0314325637a1939, 0xfa911155fefb5309, 0xf03d93eebc589f88, 0x793555ab7eba27cb,
+    0x96267c7535b763b5, 0x4bc1558b2f3458df, 0xbbb01b9283253ca2, 0x9eb1aaedfb016f17,
+    0xea9c227723ee8bcb, 0x465e15a979c1cadd, 0x92a1958a7675175f, 0x0bfacd89ec191eca,
+    0xb749faed14125d36, 0xcef980ec671f667c, 0xe51c79a85916f484, 0x82b7e12780e7401b,
+    0x8f31cc0937ae58d2, 0xd1b2ecb8b0908811, 0xb2fe3f0b8599ef07, 0x861fa7e6dcb4aa16,
+    0xdfbdcece67006ac9, 0x67a791e093e1d49b, 0x8bd6a141006042bd, 0xe0c8bb2c5c6d24e1,
+    0xaecc49914078536d, 0x58fae9f773886e19, 0xda7f5bf590966848, 0xaf39a475506a899f,
+    0x888f99797a5e012d, 0x6d8406c952429604, 0xaab37fd7d8f58178, 0xc8e5087ba6d33b84,
+    0xd5605fcdcf32e1d6, 0xfb1e4a9a90880a65, 0x855c3be0a17fcd26, 0x5cf2eea09a550680,
+    0xa6b34ad8c9dfc06f, 0xf42faa48c0ea481f, 0xd0601d8efc57b08b, 0xf13b94daf124da27,
+    0x823c12795db6ce57, 0x76c53d08d6b70859, 0xa2cb1717b52481ed, 0x54768c4b0c64ca6f,
+    0xcb7ddcdda26da268, 0xa9942f5dcf7dfd0a, 0xfe5d54150b090b02, 0xd3f93b35435d7c4d,
+    0x9efa548d26e5a6e1, 0xc47bc5014a1a6db0, 0xc6b8e9b0709f109a, 0x359ab6419ca1091c,
+    0xf867241c8cc6d4c0, 0xc30163d203c94b63, 0x9b407691d7fc44f8, 0x79e0de63425dcf1e,
+    0xc21094364dfb5636, 0x985915fc12f542e5, 0xf294b943e17a2bc4, 0x3e6f5b7b17b2939e,
+    0x979cf3ca6cec5b5a, 0xa705992ceecf9c43, 0xbd8430bd08277231, 0x50c6ff782a838354,
+    0xece53cec4a314ebd, 0xa4f8bf5635246429, 0x940f4613ae5ed136, 0x871b7795e136be9a,
+    0xb913179899f68584, 0x28e2557b59846e40, 0xe757dd7ec07426e5, 0x331aeada2fe589d0,
+    0x9096ea6f3848984f, 0x3ff0d2c85def7622, 0xb4bca50b065abe63, 0x0fed077a756b53aa,
+    0xe1ebce4dc7f16dfb, 0xd3e8495912c62895, 0x8d3360f09cf6e4bd, 0x64712dd7abbbd95d,
+    0xb080392cc4349dec, 0xbd8d794d96aacfb4, 0xdca04777f541c567, 0xecf0d7a0fc5583a1,
+    0x89e42caaf9491b60, 0xf41686c49db57245, 0xac5d37d5b79b6239, 0x311c2875c522ced6,
+    0xd77485cb25823ac7, 0x7d633293366b828c, 0x86a8d39ef77164bc, 0xae5dff9c02033198,
+    0xa8530886b54dbdeb, 0xd9f57f830283fdfd, 0xd267caa862a12d66, 0xd072df63c324fd7c,
+    0x8380dea93da4bc60, 0x4247cb9e59f71e6e, 0xa46116538d0deb78, 0x52d9be85f074e609,
+    0xcd795be870516656, 0x67902e276c921f8c, 0x806bd9714632dff6, 0x00ba1cd8a3db53b7,
+    0xa086cfcd97bf97f3, 0x80e8a40eccd228a5, 0xc8a883c0fdaf7df0, 0x6122cd128006b2ce,
+    0xfad2a4b13d1b5d6c, 0x796b805720085f82, 0x9cc3a6eec6311a63, 0xcbe3303674053bb1,
+    0xc3f490aa77bd60fc, 0xbedbfc4411068a9d, 0xf4f1b4d515acb93b, 0xee92fb5515482d45,
+    0x991711052d8bf3c5, 0x751bdd152d4d1c4b, 0xbf5cd54678eef0b6, 0xd262d45a78a0635e,
+    0xef340a98172aace4, 0x86fb897116c87c35, 0x9580869f0e7aac0e, 0xd45d35e6ae3d4da1,
+    0xbae0a846d2195712, 0x8974836059cca10a, 0xe998d258869facd7, 0x2bd1a438703fc94c,
+    0x91ff83775423cc06, 0x7b6306a34627ddd0, 0xb67f6455292cbf08, 0x1a3bc84c17b1d543,
+    0xe41f3d6a7377eeca, 0x20caba5f1d9e4a94, 0x8e938662882af53e, 0x547eb47b7282ee9d,
+    0xb23867fb2a35b28d, 0xe99e619a4f23aa44, 0xdec681f9f4c31f31, 0x6405fa00e2ec94d5,
+    0x8b3c113c38f9f37e, 0xde83bc408dd3dd05, 0xae0b158b4738705e, 0x9624ab50b148d446,
+    0xd98ddaee19068c76, 0x3badd624dd9b0958, 0x87f8a8d4cfa417c9, 0xe54ca5d70a80e5d7,
+    0xa9f6d30a038d1dbc, 0x5e9fcf4ccd211f4d, 0xd47487cc8470652b, 0x7647c32000696720,
+    0x84c8d4dfd2c63f3b, 0x29ecd9f40041e074, 0xa5fb0a17c777cf09, 0xf468107100525891,
+    0xcf79cc9db955c2cc, 0x7182148d4066eeb5, 0x81ac1fe293d599bf, 0xc6f14cd848405531,
+    0xa21727db38cb002f, 0xb8ada00e5a506a7d, 0xca9cf1d206fdc03b, 0xa6d90811f0e4851d,
+    0xfd442e4688bd304a, 0x908f4a166d1da664, 0x9e4a9cec15763e2e, 0x9a598e4e043287ff,
+    0xc5dd44271ad3cdba, 0x40eff1e1853f29fe, 0xf7549530e188c128, 0xd12bee59e68ef47d,
+    0x9a94dd3e8cf578b9, 0x82bb74f8301958cf, 0xc13a148e3032d6e7, 0xe36a52363c1faf02,
+    0xf18899b1bc3f8ca1, 0xdc44e6c3cb279ac2, 0x96f5600f15a7b7e5, 0x29ab103a5ef8c0ba,
+    0xbcb2b812db11a5de, 0x7415d448f6b6f0e8, 0xebdf661791d60f56, 0x111b495b3464ad22,
+    0x936b9fcebb25c995, 0xcab10dd900beec35, 0xb84687c269ef3bfb, 0x3d5d514f40eea743,
+    0xe65829b3046b0afa, 0x0cb4a5a3112a5113, 0x8ff71a0fe2c2e6dc, 0x47f0e785eaba72ac,
+    0xb3f4e093db73a093, 0x59ed216765690f57, 0xe0f218b8d25088b8, 0x306869c13ec3532d,
+    0x8c974f7383725573, 0x1e414218c73a13fc, 0xafbd2350644eeacf, 0xe5d1929ef90898fb,
+    0xdbac6c247d62a583, 0xdf45f746b74abf3a, 0x894bc396ce5da772, 0x6b8bba8c328eb784,
+    0xab9eb47c81f5114f, 0x066ea92f3f326565, 0xd686619ba27255a2, 0xc80a537b0efefebe,
+    0x8613fd0145877585, 0xbd06742ce95f5f37, 0xa798fc4196e952e7, 0x2c48113823b73705,
+    0xd17f3b51fca3a7a0, 0xf75a15862ca504c6, 0x82ef85133de648c4, 0x9a984d73dbe722fc,
+    0xa3ab66580d5fdaf5, 0xc13e60d0d2e0ebbb, 0xcc963fee10b7d1b3, 0x318df905079926a9,
+    0xffbbcfe994e5c61f, 0xfdf17746497f7053, 0x9fd561f1fd0f9bd3, 0xfeb6ea8bedefa634,
+    0xc7caba6e7c5382c8, 0xfe64a52ee96b8fc1, 0xf9bd690a1b68637b, 0x3dfdce7aa3c673b1,
+    0x9c1661a651213e2d, 0x06bea10ca65c084f, 0xc31bfa0fe5698db8, 0x486e494fcff30a63,
+    0xf3e2f893dec3f126, 0x5a89dba3c3efccfb, 0x986ddb5c6b3a76b7, 0xf89629465a75e01d,
+    0xbe89523386091465, 0xf6bbb397f1135824, 0xee2ba6c0678b597f, 0x746aa07ded582e2d,
+    0x94db483840b717ef, 0xa8c2a44eb4571cdd, 0xba121a4650e4ddeb, 0x92f34d62616ce414,
+    0xe896a0d7e51e1566, 0x77b020baf9c81d18, 0x915e2486ef32cd60, 0x0ace1474dc1d122f,
+    0xb5b5ada8aaff80b8, 0x0d819992132456bb, 0xe3231912d5bf60e6, 0x10e1fff697ed6c6a,
+    0x8df5efabc5979c8f, 0xca8d3ffa1ef463c2, 0xb1736b96b6fd83b3, 0xbd308ff8a6b17cb3,
+    0xddd0467c64bce4a0, 0xac7cb3f6d05ddbdf, 0x8aa22c0dbef60ee4, 0x6bcdf07a423aa96c,
+    0xad4ab7112eb3929d, 0x86c16c98d2c953c7, 0xd89d64d57a607744, 0xe871c7bf077ba8b8,
+    0x87625f056c7c4a8b, 0x11471cd764ad4973, 0xa93af6c6c79b5d2d, 0xd598e40d3dd89bd0,
+    0xd389b47879823479, 0x4aff1d108d4ec2c4, 0x843610cb4bf160cb, 0xcedf722a585139bb,
+    0xa54394fe1eedb8fe, 0xc2974eb4ee658829, 0xce947a3da6a9273e, 0x733d226229feea33,
+    0x811ccc668829b887, 0x0806357d5a3f5260, 0xa163ff802a3426a8, 0xca07c2dcb0cf26f8,
+    0xc9bcff6034c13052, 0xfc89b393dd02f0b6, 0xfc2c3f3841f17c67, 0xbbac2078d443ace3,
+    0x9d9ba7832936edc0, 0xd54b944b84aa4c0e, 0xc5029163f384a931, 0x0a9e795e65d4df12,
+    0xf64335bcf065d37d, 0x4d4617b5ff4a16d6, 0x99ea0196163fa42e, 0x504bced1bf8e4e46,
+    0xc06481fb9bcf8d39, 0xe45ec2862f71e1d7, 0xf07da27a82c37088, 0x5d767327bb4e5a4d,
+    0x964e858c91ba2655, 0x3a6a07f8d510f870, 0xbbe226efb628afea, 0x890489f70a55368c,
+    0xeadab0aba3b2dbe5, 0x2b45ac74ccea842f, 0x92c8ae6b464fc96f, 0x3b0b8bc90012929e,
+    0xb77ada0617e3bbcb, 0x09ce6ebb40173745, 0xe55990879ddcaabd, 0xcc420a6a101d0516,
+    0x8f57fa54c2a9eab6, 0x9fa946824a12232e, 0xb32df8e9f3546564, 0x47939822dc96abfa,
+    0xdff9772470297ebd, 0x59787e2b93bc56f8, 0x8bfbea76c619ef36, 0x57eb4edb3c55b65b,
+    0xaefae51477a06b03, 0xede622920b6b23f2, 0xdab99e59958885c4, 0xe95fab368e45ecee,
+    0x88b402f7fd75539b, 0x11dbcb0218ebb415, 0xaae103b5fcd2a881, 0xd652bdc29f26a11a,
+    0xd59944a37c0752a2, 0x4be76d3346f04960, 0x857fcae62d8493a5, 0x6f70a4400c562ddc,
+    0xa6dfbd9fb8e5b88e, 0xcb4ccd500f6bb953, 0xd097ad07a71f26b2, 0x7e2000a41346a7a8,
+    0x825ecc24c873782f, 0x8ed400668c0c28c9, 0xa2f67f2dfa90563b, 0x728900802f0f32fb,
+    0xcbb41ef979346bca, 0x4f2b40a03ad2ffba, 0xfea126b7d78186bc, 0xe2f610c84987bfa9,
+    0x9f24b832e6b0f436, 0x0dd9ca7d2df4d7ca, 0xc6ede63fa05d3143, 0x91503d1c79720dbc,
+    0xf8a95fcf88747d94, 0x75a44c6397ce912b, 0x9b69dbe1b548ce7c, 0xc986afbe3ee11abb,
+    0xc24452da229b021b, 0xfbe85badce996169, 0xf2d56790ab41c2a2, 0xfae27299423fb9c4,
+    0x97c560ba6b0919a5, 0xdccd879fc967d41b, 0xbdb6b8e905cb600f, 0x5400e987bbc1c921,
+    0xed246723473e3813, 0x290123e9aab23b69, 0x9436c0760c86e30b, 0xf9a0b6720aaf6522,
+    0xb94470938fa89bce, 0xf808e40e8d5b3e6a, 0xe7958cb87392c2c2, 0xb60b1d1230b20e05,
+    0x90bd77f3483bb9b9, 0xb1c6f22b5e6f48c3, 0xb4ecd5f01a4aa828, 0x1e38aeb6360b1af4,
+    0xe2280b6c20dd5232, 0x25c6da63c38de1b1, 0x8d590723948a535f, 0x579c487e5a38ad0f,
+    0xb0af48ec79ace837, 0x2d835a9df0c6d852, 0xdcdb1b2798182244, 0xf8e431456cf88e66,
+    0x8a08f0f8bf0f156b, 0x1b8e9ecb641b5900, 0xac8b2d36eed2dac5, 0xe272467e3d222f40,
+    0xd7adf884aa879177, 0x5b0ed81dcc6abb10, 0x86ccbb52ea94baea, 0x98e947129fc2b4ea,
+    0xa87fea27a539e9a5, 0x3f2398d747b36225, 0xd29fe4b18e88640e, 0x8eec7f0d19a03aae,
+    0x83a3eeeef9153e89, 0x1953cf68300424ad, 0xa48ceaaab75a8e2b, 0x5fa8c3423c052dd8,
+    0xcdb02555653131b6, 0x3792f412cb06794e, 0x808e17555f3ebf11, 0xe2bbd88bbee40bd1,
+    0xa0b19d2ab70e6ed6, 0x5b6aceaeae9d0ec5, 0xc8de047564d20a8b, 0xf245825a5a445276,
+    0xfb158592be068d2e, 0xeed6e2f0f0d56713, 0x9ced737bb6c4183d, 0x55464dd69685606c,
+    0xc428d05aa4751e4c, 0xaa97e14c3c26b887, 0xf53304714d9265df, 0xd53dd99f4b3066a9,
+    0x993fe2c6d07b7fab, 0xe546a8038efe402a, 0xbf8fdb78849a5f96, 0xde98520472bdd034,
+    0xef73d256a5c0f77c, 0x963e66858f6d4441, 0x95a8637627989aad, 0xdde7001379a44aa9,
+    0xbb127c53b17ec159, 0x5560c018580d5d53, 0xe9d71b689dde71af, 0xaab8f01e6e10b4a7,
+    0x9226712162ab070d, 0xcab3961304ca70e9, 0xb6b00d69bb55c8d1, 0x3d607b97c5fd0d23,
+    0xe45c10c42a2b3b05, 0x8cb89a7db77c506b, 0x8eb98a7a9a5b04e3, 0x77f3608e92adb243,
+    0xb267ed1940f1c61c, 0x55f038b237591ed4, 0xdf01e85f912e37a3, 0x6b6c46dec52f6689,
+    0x8b61313bbabce2c6, 0x2323ac4b3b3da016, 0xae397d8aa96c1b77, 0xabec975e0a0d081b,
+    0xd9c7dced53c72255, 0x96e7bd358c904a22, 0x881cea14545c7575, 0x7e50d64177da2e55,
+    0xaa242499697392d2, 0xdde50bd1d5d0b9ea, 0xd4ad2dbfc3d07787, 0x955e4ec64b44e865,
+    0x84ec3c97da624ab4, 0xbd5af13bef0b113f, 0xa6274bbdd0fadd61, 0xecb1ad8aeacdd58f,
+    0xcfb11ead453994ba, 0x67de18eda5814af3, 0x81ceb32c4b43fcf4, 0x80eacf948770ced8,
+    0xa2425ff75e14fc31, 0xa1258379a94d028e, 0xcad2f7f5359a3b3e, 0x096ee45813a04331,
+    0xfd87b5f28300ca0d, 0x8bca9d6e188853fd, 0x9e74d1b791e07e48, 0x775ea264cf55347e,
+    0xc612062576589dda, 0x95364afe032a819e, 0xf79687aed3eec551, 0x3a83ddbd83f52205,
+    0x9abe14cd44753b52, 0xc4926a9672793543, 0xc16d9a0095928a27, 0x75b7053c0f178294,
+    0xf1c90080baf72cb1, 0x5324c68b12dd6339, 0x971da05074da7bee, 0xd3f6fc16ebca5e04,
+    0xbce5086492111aea, 0x88f4bb1ca6bcf585, 0xec1e4a7db69561a5, 0x2b31e9e3d06c32e6,
+    0x9392ee8e921d5d07, 0x3aff322e62439fd0, 0xb877aa3236a4b449, 0x09befeb9fad487c3,
+    0xe69594bec44de15b, 0x4c2ebe687989a9b4, 0x901d7cf73ab0acd9, 0x0f9d37014bf60a11,
+    0xb424dc35095cd80f, 0x538484c19ef38c95, 0xe12e13424bb40e13, 0x2865a5f206b06fba,
+    0x8cbccc096f5088cb, 0xf93f87b7442e45d4, 0xafebff0bcb24aafe, 0xf78f69a51539d749,
+    0xdbe6fecebdedd5be, 0xb573440e5a884d1c, 0x89705f4136b4a597, 0x31680a88f8953031,
+    0xabcc77118461cefc, 0xfdc20d2b36ba7c3e, 0xd6bf94d5e57a42bc, 0x3d32907604691b4d,
+    0x8637bd05af6c69b5, 0xa63f9a49c2c1b110, 0xa7c5ac471b478423, 0x0fcf80dc33721d54,
+    0xd1b71758e219652b, 0xd3c36113404ea4a9, 0x83126e978d4fdf3b, 0x645a1cac083126ea,
+    0xa3d70a3d70a3d70a, 0x3d70a3d70a3d70a4, 0xcccccccccccccccc, 0xcccccccccccccccd,
+    0x8000000000000000, 0x0000000000000001, 0xa000000000000000, 0x0000000000000001,
+    0xc800000000000000, 0x0000000000000001, 0xfa00000000000000, 0x0000000000000001,
+    0x9c40000000000000, 0x0000000000000001, 0xc350000000000000, 0x0000000000000001,
+    0xf424000000000000, 0x0000000000000001, 0x9896800000000000, 0x0000000000000001,
+    0xbebc200000000000, 0x0000000000000001, 0xee6b280000000000, 0x0000000000000001,
+    0x9502f90000000000, 0x0000000000000001, 0xba43b74000000000, 0x0000000000000001,
+    0xe8d4a51000000000, 0x0000000000000001, 0x9184e72a00000000, 0x0000000000000001,
+    0xb5e620f480000000, 0x0000000000000001, 0xe35fa931a0000000, 0x0000000000000001,
+    0x8e1bc9bf04000000, 0x0000000000000001, 0xb1a2bc2ec5000000, 0x0000000000000001,
+    0xde0b6b3a76400000, 0x0000000000000001, 0x8ac7230489e80000, 0x0000000000000001,
+    0xad78ebc5ac620000, 0x0000000000000001, 0xd8d726b7177a8000, 0x0000000000000001,
+    0x878678326eac9000, 0x0000000000000001, 0xa968163f0a57b400, 0x0000000000000001,
+    0xd3c21bcecceda100, 0x0000000000000001, 0x84595161401484a0, 0x0000000000000001,
+    0xa56fa5b99019a5c8, 0x0000000000000001, 0xcecb8f27f4200f3a, 0x0000000000000001,
+    0x813f3978f8940984, 0x4000000000000001, 0xa18f07d736b90be5, 0x5000000000000001,
+    0xc9f2c9cd04674ede, 0xa400000000000001, 0xfc6f7c4045812296, 0x4d00000000000001,
+    0x9dc5ada82b70b59d, 0xf020000000000001, 0xc5371912364ce305, 0x6c28000000000001,
+    0xf684df56c3e01bc6, 0xc732000000000001, 0x9a130b963a6c115c, 0x3c7f400000000001,
+    0xc097ce7bc90715b3, 0x4b9f100000000001, 0xf0bdc21abb48db20, 0x1e86d40000000001,
+    0x96769950b50d88f4, 0x1314448000000001, 0xbc143fa4e250eb31, 0x17d955a000000001,
+    0xeb194f8e1ae525fd, 0x5dcfab0800000001, 0x92efd1b8d0cf37be, 0x5aa1cae500000001,
+    0xb7abc627050305ad, 0xf14a3d9e40000001, 0xe596b7b0c643c719, 0x6d9ccd05d0000001,
+    0x8f7e32ce7bea5c6f, 0xe4820023a2000001, 0xb35dbf821ae4f38b, 0xdda2802c8a800001,
+    0xe0352f62a19e306e, 0xd50b2037ad200001, 0x8c213d9da502de45, 0x4526f422cc340001,
+    0xaf298d050e4395d6, 0x9670b12b7f410001, 0xdaf3f04651d47b4c, 0x3c0cdd765f114001,
+    0x88d8762bf324cd0f, 0xa5880a69fb6ac801, 0xab0e93b6efee0053, 0x8eea0d047a457a01,
+    0xd5d238a4abe98068, 0x72a4904598d6d881, 0x85a36366eb71f041, 0x47a6da2b7f864751,
+    0xa70c3c40a64e6c51, 0x999090b65f67d925, 0xd0cf4b50cfe20765, 0xfff4b4e3f741cf6e,
+    0x82818f1281ed449f, 0xbff8f10e7a8921a5, 0xa321f2d7226895c7, 0xaff72d52192b6a0e,
+    0xcbea6f8ceb02bb39, 0x9bf4f8a69f764491, 0xfee50b7025c36a08, 0x02f236d04753d5b5,
+    0x9f4f2726179a2245, 0x01d762422c946591, 0xc722f0ef9d80aad6, 0x424d3ad2b7b97ef6,
+    0xf8ebad2b84e0d58b, 0xd2e0898765a7deb3, 0x9b934c3b330c8577, 0x63cc55f49f88eb30,
+    0xc2781f49ffcfa6d5, 0x3cbf6b71c76b25fc, 0xf316271c7fc3908a, 0x8bef464e3945ef7b,
+    0x97edd871cfda3a56, 0x97758bf0e3cbb5ad, 0xbde94e8e43d0c8ec, 0x3d52eeed1cbea318,
+    0xed63a231d4c4fb27, 0x4ca7aaa863ee4bde, 0x945e455f24fb1cf8, 0x8fe8caa93e74ef6b,
+    0xb975d6b6ee39e436, 0xb3e2fd538e122b45, 0xe7d34c64a9c85d44, 0x60dbbca87196b617,
+    0x90e40fbeea1d3a4a, 0xbc8955e946fe31ce, 0xb51d13aea4a488dd, 0x6babab6398bdbe42,
+    0xe264589a4dcdab14, 0xc696963c7eed2dd2, 0x8d7eb76070a08aec, 0xfc1e1de5cf543ca3,
+    0xb0de65388cc8ada8, 0x3b25a55f43294bcc, 0xdd15fe86affad912, 0x49ef0eb713f39ebf,
+    0x8a2dbf142dfcc7ab, 0x6e3569326c784338, 0xacb92ed9397bf996, 0x49c2c37f07965405,
+    0xd7e77a8f87daf7fb, 0xdc33745ec97be907, 0x86f0ac99b4e8dafd, 0x69a028bb3ded71a4,
+    0xa8acd7c0222311bc, 0xc40832ea0d68ce0d, 0xd2d80db02aabd62b, 0xf50a3fa490c30191,
+    0x83c7088e1aab65db, 0x792667c6da79e0fb, 0xa4b8cab1a1563f52, 0x577001b891185939,
+    0xcde6fd5e09abcf26, 0xed4c0226b55e6f87, 0x80b05e5ac60b6178, 0x544f8158315b05b5,
+    0xa0dc75f1778e39d6, 0x696361ae3db1c722, 0xc913936dd571c84c, 0x03bc3a19cd1e38ea,
+    0xfb5878494ace3a5f, 0x04ab48a04065c724, 0x9d174b2dcec0e47b, 0x62eb0d64283f9c77,
+    0xc45d1df942711d9a, 0x3ba5d0bd324f8395, 0xf5746577930d6500, 0xca8f44ec7ee3647a,
+    0x9968bf6abbe85f20, 0x7e998b13cf4e1ecc, 0xbfc2ef456ae276e8, 0x9e3fedd8c321a67f,
+    0xefb3ab16c59b14a2, 0xc5cfe94ef3ea101f, 0x95d04aee3b80ece5, 0xbba1f1d158724a13,
+    0xbb445da9ca61281f, 0x2a8a6e45ae8edc98, 0xea1575143cf97226, 0xf52d09d71a3293be,
+    0x924d692ca61be758, 0x593c2626705f9c57, 0xb6e0c377cfa2e12e, 0x6f8b2fb00c77836d,
+    0xe498f455c38b997a, 0x0b6dfb9c0f956448, 0x8edf98b59a373fec, 0x4724bd4189bd5ead,
+    0xb2977ee300c50fe7, 0x58edec91ec2cb658, 0xdf3d5e9bc0f653e1, 0x2f2967b66737e3ee,
+    0x8b865b215899f46c, 0xbd79e0d20082ee75, 0xae67f1e9aec07187, 0xecd8590680a3aa12,
+    0xda01ee641a708de9, 0xe80e6f4820cc9496, 0x884134fe908658b2, 0x3109058d147fdcde,
+    0xaa51823e34a7eede, 0xbd4b46f0599fd416, 0xd4e5e2cdc1d1ea96, 0x6c9e18ac7007c91b,
+    0x850fadc09923329e, 0x03e2cf6bc604ddb1, 0xa6539930bf6bff45, 0x84db8346b786151d,
+    0xcfe87f7cef46ff16, 0xe612641865679a64, 0x81f14fae158c5f6e, 0x4fcb7e8f3f60c07f,
+    0xa26da3999aef7749, 0xe3be5e330f38f09e, 0xcb090c8001ab551c, 0x5cadf5bfd3072cc6,
+    0xfdcb4fa002162a63, 0x73d9732fc7c8f7f7, 0x9e9f11c4014dda7e, 0x2867e7fddcdd9afb,
+    0xc646d63501a1511d, 0xb281e1fd541501b9, 0xf7d88bc24209a565, 0x1f225a7ca91a4227,
+    0x9ae757596946075f, 0x3375788de9b06959, 0xc1a12d2fc3978937, 0x0052d6b1641c83af,
+    0xf209787bb47d6b84, 0xc0678c5dbd23a49b, 0x9745eb4d50ce6332, 0xf840b7ba963646e1,
+    0xbd176620a501fbff, 0xb650e5a93bc3d899, 0xec5d3fa8ce427aff, 0xa3e51f138ab4cebf,
+    0x93ba47c980e98cdf, 0xc66f336c36b10138, 0xb8a8d9bbe123f017, 0xb80b0047445d4185,
+    0xe6d3102ad96cec1d, 0xa60dc059157491e6, 0x9043ea1ac7e41392, 0x87c89837ad68db30,
+    0xb454e4a179dd1877, 0x29babe4598c311fc, 0xe16a1dc9d8545e94, 0xf4296dd6fef3d67b,
+    0x8ce2529e2734bb1d, 0x1899e4a65f58660d, 0xb01ae745b101e9e4, 0x5ec05dcff72e7f90,
+    0xdc21a1171d42645d, 0x76707543f4fa1f74, 0x899504ae72497eba, 0x6a06494a791c53a9,
+    0xabfa45da0edbde69, 0x0487db9d17636893, 0xd6f8d7509292d603, 0x45a9d2845d3c42b7,
+    0x865b86925b9bc5c2, 0x0b8a2392ba45a9b3, 0xa7f26836f282b732, 0x8e6cac7768d7141f,
+    0xd1ef0244af2364ff, 0x3207d795430cd927, 0x8335616aed761f1f, 0x7f44e6bd49e807b9,
+    0xa402b9c5a8d3a6e7, 0x5f16206c9c6209a7, 0xcd036837130890a1, 0x36dba887c37a8c10,
+    0x802221226be55a64, 0xc2494954da2c978a, 0xa02aa96b06deb0fd, 0xf2db9baa10b7bd6d,
+    0xc83553c5c8965d3d, 0x6f92829494e5acc8, 0xfa42a8b73abbf48c, 0xcb772339ba1f17fa,
+    0x9c69a97284b578d7, 0xff2a760414536efc, 0xc38413cf25e2d70d, 0xfef5138519684abb,
+    0xf46518c2ef5b8cd1, 0x7eb258665fc25d6a, 0x98bf2f79d5993802, 0xef2f773ffbd97a62,
+    0xbeeefb584aff8603, 0xaafb550ffacfd8fb, 0xeeaaba2e5dbf6784, 0x95ba2a53f983cf39,
+    0x952ab45cfa97a0b2, 0xdd945a747bf26184, 0xba756174393d88df, 0x94f971119aeef9e5,
+    0xe912b9d1478ceb17, 0x7a37cd5601aab85e, 0x91abb422ccb812ee, 0xac62e055c10ab33b,
+    0xb616a12b7fe617aa, 0x577b986b314d600a, 0xe39c49765fdf9d94, 0xed5a7e85fda0b80c,
+    0x8e41ade9fbebc27d, 0x14588f13be847308, 0xb1d219647ae6b31c, 0x596eb2d8ae258fc9,
+    0xde469fbd99a05fe3, 0x6fca5f8ed9aef3bc, 0x8aec23d680043bee, 0x25de7bb9480d5855,
+    0xada72ccc20054ae9, 0xaf561aa79a10ae6b, 0xd910f7ff28069da4, 0x1b2ba1518094da05,
+    0x87aa9aff79042286, 0x90fb44d2f05d0843, 0xa99541bf57452b28, 0x353a1607ac744a54,
+    0xd3fa922f2d1675f2, 0x42889b8997915ce9, 0x847c9b5d7c2e09b7, 0x69956135febada12,
+    0xa59bc234db398c25, 0x43fab9837e699096, 0xcf02b2c21207ef2e, 0x94f967e45e03f4bc,
+    0x8161afb94b44f57d, 0x1d1be0eebac278f6, 0xa1ba1ba79e1632dc, 0x6462d92a69731733,
+    0xca28a291859bbf93, 0x7d7b8f7503cfdcff, 0xfcb2cb35e702af78, 0x5cda735244c3d43f,
+    0x9defbf01b061adab, 0x3a0888136afa64a8, 0xc56baec21c7a1916, 0x088aaa1845b8fdd1,
+    0xf6c69a72a3989f5b, 0x8aad549e57273d46, 0x9a3c2087a63f6399, 0x36ac54e2f678864c,
+    0xc0cb28a98fcf3c7f, 0x84576a1bb416a7de, 0xf0fdf2d3f3c30b9f, 0x656d44a2a11c51d6,
+    0x969eb7c47859e743, 0x9f644ae5a4b1b326, 0xbc4665b596706114, 0x873d5d9f0dde1fef,
+    0xeb57ff22fc0c7959, 0xa90cb506d155a7eb, 0x9316ff75dd87cbd8, 0x09a7f12442d588f3,
+    0xb7dcbf5354e9bece, 0x0c11ed6d538aeb30, 0xe5d3ef282a242e81, 0x8f1668c8a86da5fb,
+    0x8fa475791a569d10, 0xf96e017d694487bd, 0xb38d92d760ec4455, 0x37c981dcc395a9ad,
+    0xe070f78d3927556a, 0x85bbe253f47b1418, 0x8c469ab843b89562, 0x93956d7478ccec8f,
+    0xaf58416654a6babb, 0x387ac8d1970027b3, 0xdb2e51bfe9d0696a, 0x06997b05fcc0319f,
+    0x88fcf317f22241e2, 0x441fece3bdf81f04, 0xab3c2fddeeaad25a, 0xd527e81cad7626c4,
+    0xd60b3bd56a5586f1, 0x8a71e223d8d3b075, 0x85c7056562757456, 0xf6872d5667844e4a,
+    0xa738c6bebb12d16c, 0xb428f8ac016561dc, 0xd106f86e69d785c7, 0xe13336d701beba53,
+    0x82a45b450226b39c, 0xecc0024661173474, 0xa34d721642b06084, 0x27f002d7f95d0191,
+    0xcc20ce9bd35c78a5, 0x31ec038df7b441f5, 0xff290242c83396ce, 0x7e67047175a15272,
+    0x9f79a169bd203e41, 0x0f0062c6e984d387, 0xc75809c42c684dd1, 0x52c07b78a3e60869,
+    0xf92e0c3537826145, 0xa7709a56ccdf8a83, 0x9bbcc7a142b17ccb, 0x88a66076400bb692,
+    0xc2abf989935ddbfe, 0x6acff893d00ea436, 0xf356f7ebf83552fe, 0x0583f6b8c4124d44,
+    0x98165af37b2153de, 0xc3727a337a8b704b, 0xbe1bf1b059e9a8d6, 0x744f18c0592e4c5d,
+    0xeda2ee1c7064130c, 0x1162def06f79df74, 0x9485d4d1c63e8be7, 0x8addcb5645ac2ba9,
+    0xb9a74a0637ce2ee1, 0x6d953e2bd7173693, 0xe8111c87c5c1ba99, 0xc8fa8db6ccdd0438,
+    0x910ab1d4db9914a0, 0x1d9c9892400a22a3, 0xb54d5e4a127f59c8, 0x2503beb6d00cab4c,
+    0xe2a0b5dc971f303a, 0x2e44ae64840fd61e, 0x8da471a9de737e24, 0x5ceaecfed289e5d3,
+    0xb10d8e1456105dad, 0x7425a83e872c5f48, 0xdd50f1996b947518, 0xd12f124e28f7771a,
+    0x8a5296ffe33cc92f, 0x82bd6b70d99aaa70, 0xace73cbfdc0bfb7b, 0x636cc64d1001550c,
+    0xd8210befd30efa5a, 0x3c47f7e05401aa4f, 0x8714a775e3e95c78, 0x65acfaec34810a72,
+    0xa8d9d1535ce3b396, 0x7f1839a741a14d0e, 0xd31045a8341ca07c, 0x1ede48111209a051,
+    0x83ea2b892091e44d, 0x934aed0aab460433, 0xa4e4b66b68b65d60, 0xf81da84d56178540,
+    0xce1de40642e3f4b9, 0x36251260ab9d668f, 0x80d2ae83e9ce78f3, 0xc1d72b7c6b42601a,
+    0xa1075a24e4421730, 0xb24cf65b8612f820, 0xc94930ae1d529cfc, 0xdee033f26797b628,
+    0xfb9b7cd9a4a7443c, 0x169840ef017da3b2, 0x9d412e0806e88aa5, 0x8e1f289560ee864f,
+    0xc491798a08a2ad4e, 0xf1a6f2bab92a27e3, 0xf5b5d7ec8acb58a2, 0xae10af696774b1dc,
+    0x9991a6f3d6bf1765, 0xacca6da1e0a8ef2a, 0xbff610b0cc6edd3f, 0x17fd090a58d32af4,
+    0xeff394dcff8a948e, 0xddfc4b4cef07f5b1, 0x95f83d0a1fb69cd9, 0x4abdaf101564f98f,
+    0xbb764c4ca7a4440f, 0x9d6d1ad41abe37f2, 0xea53df5fd18d5513, 0x84c86189216dc5ee,
+    0x92746b9be2f8552c, 0x32fd3cf5b4e49bb5, 0xb7118682dbb66a77, 0x3fbc8c33221dc2a2,
+    0xe4d5e82392a40515, 0x0fabaf3feaa5334b, 0x8f05b1163ba6832d, 0x29cb4d87f2a7400f,
+    0xb2c71d5bca9023f8, 0x743e20e9ef511013, 0xdf78e4b2bd342cf6, 0x914da9246b255417,
+    0x8bab8eefb6409c1a, 0x1ad089b6c2f7548f, 0xae9672aba3d0c320, 0xa184ac2473b529b2,
+    0xda3c0f568cc4f3e8, 0xc9e5d72d90a2741f, 0x8865899617fb1871, 0x7e2fa67c7a658893,
+    0xaa7eebfb9df9de8d, 0xddbb901b98feeab8, 0xd51ea6fa85785631, 0x552a74227f3ea566,
+    0x8533285c936b35de, 0xd53a88958f872760, 0xa67ff273b8460356, 0x8a892abaf368f138,
+    0xd01fef10a657842c, 0x2d2b7569b0432d86, 0x8213f56a67f6b29b, 0x9c3b29620e29fc74,
+    0xa298f2c501f45f42, 0x8349f3ba91b47b90, 0xcb3f2f7642717713, 0x241c70a936219a74,
+    0xfe0efb53d30dd4d7, 0xed238cd383aa0111, 0x9ec95d1463e8a506, 0xf4363804324a40ab,
+    0xc67bb4597ce2ce48, 0xb143c6053edcd0d6, 0xf81aa16fdc1b81da, 0xdd94b7868e94050b,
+    0x9b10a4e5e9913128, 0xca7cf2b4191c8327, 0xc1d4ce1f63f57d72, 0xfd1c2f611f63a3f1,
+    0xf24a01a73cf2dccf, 0xbc633b39673c8ced, 0x976e41088617ca01, 0xd5be0503e085d814,
+    0xbd49d14aa79dbc82, 0x4b2d8644d8a74e19, 0xec9c459d51852ba2, 0xddf8e7d60ed1219f,
+    0x93e1ab8252f33b45, 0xcabb90e5c942b504, 0xb8da1662e7b00a17, 0x3d6a751f3b936244,
+    0xe7109bfba19c0c9d, 0x0cc512670a783ad5, 0x906a617d450187e2, 0x27fb2b80668b24c6,
+    0xb484f9dc9641e9da, 0xb1f9f660802dedf7, 0xe1a63853bbd26451, 0x5e7873f8a0396974,
+    0x8d07e33455637eb2, 0xdb0b487b6423e1e9, 0xb049dc016abc5e5f, 0x91ce1a9a3d2cda63,
+    0xdc5c5301c56b75f7, 0x7641a140cc7810fc, 0x89b9b3e11b6329ba, 0xa9e904c87fcb0a9e,
+    0xac2820d9623bf429, 0x546345fa9fbdcd45, 0xd732290fbacaf133, 0xa97c177947ad4096,
+    0x867f59a9d4bed6c0, 0x49ed8eabcccc485e, 0xa81f301449ee8c70, 0x5c68f256bfff5a75,
+    0xd226fc195c6a2f8c, 0x73832eec6fff3112, 0x83585d8fd9c25db7, 0xc831fd53c5ff7eac,
+    0xa42e74f3d032f525, 0xba3e7ca8b77f5e56, 0xcd3a1230c43fb26f, 0x28ce1bd2e55f35ec,
+    0x80444b5e7aa7cf85, 0x7980d163cf5b81b4, 0xa0555e361951c366, 0xd7e105bcc3326220,
+    0xc86ab5c39fa63440, 0x8dd9472bf3fefaa8, 0xfa856334878fc150, 0xb14f98f6f0feb952,
+    0x9c935e00d4b9d8d2, 0x6ed1bf9a569f33d4, 0xc3b8358109e84f07, 0x0a862f80ec4700c9,
+    0xf4a642e14c6262c8, 0xcd27bb612758c0fb, 0x98e7e9cccfbd7dbd, 0x8038d51cb897789d,
+    0xbf21e44003acdd2c, 0xe0470a63e6bd56c4, 0xeeea5d5004981478, 0x1858ccfce06cac75,
+    0x95527a5202df0ccb, 0x0f37801e0c43ebc9, 0xbaa718e68396cffd, 0xd30560258f54e6bb,
+    0xe950df20247c83fd, 0x47c6b82ef32a206a, 0x91d28b7416cdd27e, 0x4cdc331d57fa5442,
+    0xb6472e511c81471d, 0xe0133fe4adf8e953, 0xe3d8f9e563a198e5, 0x58180fddd97723a7,
+    0x8e679c2f5e44ff8f, 0x570f09eaa7ea7649, 0xb201833b35d63f73, 0x2cd2cc6551e513db,
+    0xde81e40a034bcf4f, 0xf8077f7ea65e58d2, 0x8b112e86420f6191, 0xfb04afaf27faf783,
+    0xadd57a27d29339f6, 0x79c5db9af1f9b564, 0xd94ad8b1c7380874, 0x18375281ae7822bd,
+    0x87cec76f1c830548, 0x8f2293910d0b15b6, 0xa9c2794ae3a3c69a, 0xb2eb3875504ddb23,
+    0xd433179d9c8cb841, 0x5fa60692a46151ec, 0x849feec281d7f328, 0xdbc7c41ba6bcd334,
+    0xa5c7ea73224deff3, 0x12b9b522906c0801, 0xcf39e50feae16bef, 0xd768226b34870a01,
+    0x81842f29f2cce375, 0xe6a1158300d46641, 0xa1e53af46f801c53, 0x60495ae3c1097fd1,
+    0xca5e89b18b602368, 0x385bb19cb14bdfc5, 0xfcf62c1dee382c42, 0x46729e03dd9ed7b6,
+    0x9e19db92b4e31ba9, 0x6c07a2c26a8346d2, 0xc5a05277621be293, 0xc7098b7305241886,
+    0xf70867153aa2db38, 0xb8cbee4fc66d1ea8,
+};
+
+static int32_t floor_log2_pow10(int32_t power_of_ten) {
+    return (power_of_ten * 1741647) >> 19;
+}
+
+// High 64 bits of the 192-bit product power * value, with the lowest bit set
+// when any discarded bit is.
+static uint64_t round_to_odd(const uint64_t *power, uint64_t value) {
+    uint64_t high, low, low_high, low_low;
+    multiply_64(power[0], value, &high, &low);
+    multiply_64(power[1], value, &low_high, &low_low);
+    uint64_t middle = low + low_high;
+    high += middle < low;
+    return high | (middle > 1);
+}
+
+// Shortest decimal digits * 10^*power_of_ten that rounds to the positive
+// finite double with these bits.
+static uint64_t shortest_decimal(uint64_t bits, int32_t *power_of_ten) {
+    uint64_t fraction = bits & ((1ULL << 52) - 1);
+    int32_t biased_exponent = (int32_t)(bits >> 52);
+    uint64_t significand;
+    int32_t exponent;
+    if (biased_exponent != 0) {
+        significand = fraction | (1ULL << 52);
+        exponent = biased_exponent - 1075;
+        if (exponent <= 0 && exponent > -53
+            && (significand & ((1ULL << -exponent) - 1)) == 0) {
+            *power_of_ten = 0;
+            return significand >> -exponent;
+        }
+    } else {
+        significand = fraction;
+        exponent = -1074;
+    }
+
+    // The number and the bounds of its rounding interval, times four. The
+    // lower bound is closer when the number is a power of two.
+    bool lower_closer = fraction == 0 && biased_exponent > 1;
+    bool even = (significand & 1) == 0;
+    uint64_t lower_bound = 4 * significand - 2 + lower_closer;
+    uint64_t number = 4 * significand;
+    uint64_t upper_bound = 4 * significand + 2;
+
+    int32_t k = (exponent * 1262611 - (lower_closer ? 524031 : 0)) >> 22;
+    int32_t shift = exponent + floor_log2_pow10(-k) + 1;
+    const uint64_t *power = &power_of_ten_128[2 * (-k - POWER_OF_TEN_MIN)];
+    uint64_t scaled_lower = round_to_odd(power, lower_bound << shift) + !even;
+    uint64_t scaled = round_to_odd(power, number << shift);
+    uint64_t scaled_upper = round_to_odd(power, upper_bound << shift) - !even;
+
+    // Prefer one digit fewer when exactly one of its neighbours is inside
+    // the interval, then the same at full length; otherwise round to nearest.
+    uint64_t digits = scaled / 4;
+    if (digits >= 10) {
+        uint64_t shorter = digits / 10;
+        bool down_inside = scaled_lower <= 40 * shorter;
+        bool up_inside = 40 * shorter + 40 <= scaled_upper;
+        if (down_inside != up_inside) {
+            *power_of_ten = k + 1;
+            return shorter + up_inside;
+        }
+    }
+    bool down_inside = scaled_lower <= 4 * digits;
+    bool up_inside = 4 * digits + 4 <= scaled_upper;
+    *power_of_ten = k;
+    if (down_inside != up_inside) {
+        return digits + up_inside;
+    }
+    uint64_t middle = 4 * digits + 2;
+    return digits + (scaled > middle || (scaled == middle && (digits & 1) != 0));
+}
+
+// Writes number into text, which must hold at least 32 bytes, and returns the
+// length written, without a terminating '\0'.
+static int32_t format_number(double number, char *text) {
+    char *out = text;
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    if (isnan(number)) {
+        memcpy(out, "+nan.0", 6);
+        return 6;
+    }
+    if (isinf(number)) {
+        memcpy(out, number < 0 ? "-inf.0" : "+inf.0", 6);
+        return 6;
+    }
+    if (bits >> 63 && number != 0.0) {
+        *out++ = '-';
+    }
+    bits &= ~(1ULL << 63);
+
+    uint64_t digits;
+    int32_t power_of_ten = 0;
+    if (bits == 0) {
+        digits = 0;
+    } else {
+        digits = shortest_decimal(bits, &power_of_ten);
+        while (digits % 10 == 0) {
+            digits /= 10;
+            power_of_ten++;
+        }
+    }
+    char digit_text[20];
+    int32_t digit_count = 0;
+    do {
+        digit_text[19 - digit_count++] = (char)('0' + digits % 10);
+        digits /= 10;
+    } while (digits != 0);
+    const char *first = digit_text + 20 - digit_count;
+
+    // point is where the decimal point goes, counted in digits from the first.
+    int32_t point = digit_count + power_of_ten;
+    if (digit_count <= point && point <= 21) {
+        memcpy(out, first, digit_count);
+        out += digit_count;
+        memset(out, '0', point - digit_count);
+        out += point - digit_count;
+    } else if (0 < point && point <= 21) {
+        memcpy(out, first, point);
+        out += point;
+        *out++ = '.';
+        memcpy(out, first + point, digit_count - point);
+        out += digit_count - point;
+    } else if (-6 < point && point <= 0) {
+        *out++ = '0';
+        *out++ = '.';
+        memset(out, '0', -point);
+        out += -point;
+        memcpy(out, first, digit_count);
+        out += digit_count;
+    } else {
+        *out++ = *first;
+        if (digit_count > 1) {
+            *out++ = '.';
+            memcpy(out, first + 1, digit_count - 1);
+            out += digit_count - 1;
+        }
+        int32_t exponent = point - 1;
+        *out++ = 'e';
+        *out++ = exponent < 0 ? '-' : '+';
+        exponent = exponent < 0 ? -exponent : exponent;
+        if (exponent >= 100) {
+            *out++ = (char)('0' + exponent / 100);
+        }
+        if (exponent >= 10) {
+            *out++ = (char)('0' + exponent / 10 % 10);
+        }
+        *out++ = (char)('0' + exponent % 10);
+    }
+    return (int32_t)(out - text);
+}
+
+// Reads the spellings format_number gives infinities and NaN, which must make
+// up the whole token; anything longer, like +inf.0x, stays a symbol.
+static bool scan_special_number(const char *token, size_t length, double *number) {
+    if (length != 6) {
+        return false;
+    }
+    if (memcmp(token, "+inf.0", 6) == 0) {
+        *number = HUGE_VAL;
+    } else if (memcmp(token, "-inf.0", 6) == 0) {
+        *number = -HUGE_VAL;
+    } else if (memcmp(token, "+nan.0", 6) == 0) {
+        *number = NAN;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static pval *parse_atom(char **input_ptr) {
+    if (isdigit(**input_ptr) || (**input_ptr == '-' && isdigit((*input_ptr)[1]))
+        || **input_ptr == '.') {
+        double parsed_num;
+        const char *end_ptr;
+        if (!scan_number(*input_ptr, &parsed_num, &end_ptr)) {
+            return pval_error("SyntaxError", "Invalid number format");
+        }
+        *input_ptr = (char *)end_ptr;
+        return pval_number(parsed_num);
+    } else if (strncmp(*input_ptr, "#t", 2) == 0) {
+        *input_ptr += 2;
+        return pval_bool(true);
+    } else if (strncmp(*input_ptr, "#f", 2) == 0) {
+        *input_ptr += 2;
+        return pval_bool(false);
+    } else {
+        char *symbol_start = *input_ptr;
+        *input_ptr += span_token(*input_ptr);
+        if (*input_ptr == symbol_start) {
+            return pval_error("SyntaxError", "Empty symbol or unparsable token");
+        }
+        double special_number;
+        if (scan_special_number(symbol_start, *input_ptr - symbol_start, &special_number)) {
+            return pval_number(special_number);
+        }
+        return pval_symbol_len(symbol_start, *input_ptr - symbol_start);
+    }
+}
+
+// Where the text being parsed starts, for locating syntax errors.
+typedef struct parse_source {
+    const char *text;
+    int32_t line; // Line and column of text[0]
+    int32_t column;
+} parse_source_t;
+
+// Syntax error for the text at position at, located by line and column.
+// Only computed once parsing has failed.
+static pval *parse_error(const parse_source_t *source, const char *at, const char *message) {
+    int32_t line = source->line;
+    int32_t column = source->column;
+    for (const char *c = source->text; c < at; c++) {
+        if (*c == '\n') {
+            line++;
+            column = 1;
+        } else {
+            column++;
+        }
+    }
+    char located[256];
+    snprintf(located, sizeof(located), "%s at line %d, column %d", message, line, column);
+    return pval_error("SyntaxError", located);
+}
+
+typedef struct open_list {
+    pval *list;
+    char *open; // Its '(' in the input
+} open_list_t;
+
+// Parses one expression from *input_ptr and advances past it; returns NULL
+// if only whitespace is left. Parentheses are checked in the same pass: lists
+// still waiting for their ')' are kept on a work stack, each finished item is
+// added to the innermost one, and a ')' without a list to close or a list
+// left open at the end of the input is reported with its position.
+pval *pval_parse(char **input_ptr, const parse_source_t *source) {
+    work_stack_t open_lists;
+    work_stack_init(&open_lists, sizeof(open_list_t));
+    pval *parsed_value = NULL;
+    while (true) {
+        skip_whitespace(input_ptr);
+        pval *parsed_item;
+        if (**input_ptr == '\0') {
+            if (open_lists.count > 0) {
+                open_list_t *innermost = work_stack_top(&open_lists);
+                parsed_value = parse_error(source, innermost->open, "Missing ')' for '('");
+            }
+            break;
+        }
+        if (**input_ptr == '(') {
+            open_list_t *frame = work_stack_push(&open_lists);
+            if (frame == NULL || (frame->list = pval_list()) == NULL) {
+                open_lists.count -= frame != NULL;
+                parsed_value = pval_error("MemoryError", "Failed to allocate list");
+                break;
+            }
+            frame->open = (*input_ptr)++;
+            continue;
+        }
+        if (**input_ptr == ')') {
+            if (open_lists.count == 0) {
+                parsed_value = parse_error(source, *input_ptr, "Unexpected ')'");
+                (*input_ptr)++;
+                break;
+            }
+            (*input_ptr)++;
+            parsed_item = ((open_list_t *)work_stack_top(&open_lists))->list;
+            open_lists.count--;
+        } else {
+            char *atom_start = *input_ptr;
+            parsed_item = parse_atom(input_ptr);
+            if (parsed_item == NULL) {
+                parsed_value = pval_error("MemoryError", "Failed to allocate atom");
+                break;
+            }
+            if (parsed_item->type == PVAL_ERROR) {
+                parsed_value = parse_error(source, atom_start, parsed_item->error_message);
+                pval_delete(parsed_item);
+                break;
+            }
+        }
+        parsed_item = pval_hash_cons(parsed_item);
+        if (open_lists.count == 0) {
+            parsed_value = parsed_item;
+            break;
+        }
+        pval_add(((open_list_t *)work_stack_top(&open_lists))->list, parsed_item);
+    }
+    for (int32_t i = 0; i < open_lists.count; i++) {
+        pval_delete(((open_list_t *)open_lists.items)[i].list);
+    }
+    work_stack_free(&open_lists);
+    return parsed_value;
+}
+
+// Builtin PSI Op Functions
+pval *builtin_add(pval **args, int32_t arg_count);
+pval *builtin_sub(pval **args, int32_t arg_count);
+pval *builtin_mul(pval **args, int32_t arg_count);
+pval *builtin_div(pval **args, int32_t arg_count);
+pval *builtin_eq(pval **args, int32_t arg_count);
+pval *builtin_quit(pval **args, int32_t arg_count);
+pval *builtin_memoize(pval **args, int32_t arg_count);
+pval *builtin_memo_stats(pval **args, int32_t arg_count);
+pval *builtin_list(pval **args, int32_t arg_count);
+pval *builtin_force(pval **args, int32_t arg_count);
+pval *builtin_make_promise(pval **args, int32_t arg_count);
+pval *builtin_make_generator(pval **args, int32_t arg_count);
+pval *builtin_yield(pval **args, int32_t arg_count);
+pval *builtin_generator_done(pval **args, int32_t arg_count);
+pval *builtin_values(pval **args, int32_t arg_count);
+pval *builtin_call_with_values(pval **args, int32_t arg_count);
+pval *builtin_serialize(pval **args, int32_t arg_count);
+pval *builtin_deserialize(pval **args, int32_t arg_count);
+pval *builtin_write_bytes(pval **args, int32_t arg_count);
+pval *builtin_read_bytes(pval **args, int32_t arg_count);
+static pval *values_error(void);
+static pval *single_value(pval *value);
+static pval *deserialize_value(const uint8_t *data, size_t length, bool with_code);
+
+pval *builtin_add(pval **args, int32_t arg_count) {
+    double running_sum = 0.0;
+    if (arg_count == 0) {
         return pval_number(0.0);
     }
 
-    for (int32_t i = 0; i < arg_count; i++) {
-        if (args[i]->type != PVAL_NUMBER) {
-            return pval_error("TypeError", "Arguments to + must be numbers");
+    for (int32_t i = 0; i < arg_count; i++) {
+        if (args[i]->type != PVAL_NUMBER) {
+            return pval_error("TypeError", "Arguments to + must be numbers");
+        }
+        running_sum += args[i]->number;
+    }
+    return pval_number(running_sum);
+}
+
+pval *builtin_sub(pval **args, int32_t arg_count) {
+    if (arg_count == 0) {
+        return pval_error("ArityError", "'-' requires at least one argument");
+    }
+    if (args[0]->type != PVAL_NUMBER) {
+        return pval_error("TypeError", "First argument to - must be a number");
+    }
+
+    if (arg_count == 1) {
+        return pval_number(-args[0]->number);
+    } else if (arg_count == 2) {
+        if (args[1]->type != PVAL_NUMBER) {
+            return pval_error("TypeError", "Second argument to - must be a number");
+        }
+        return pval_number(args[0]->number - args[1]->number);
+    }
+    return pval_error("ArityError", "'-' currently supports 1 or 2 arguments");
+}
+
+pval *builtin_mul(pval **args, int32_t arg_count) {
+    double running_product = 1.0;
+    if (arg_count == 0) {
+        return pval_number(1.0);
+    }
+
+    for (int32_t i = 0; i < arg_count; i++) {
+        if (args[i]->type != PVAL_NUMBER) {
+            return pval_error("TypeError", "Arguments to * must be numbers");
+        }
+        running_product *= args[i]->number;
+    }
+    return pval_number(running_product);
+}
+
+pval *builtin_div(pval **args, int32_t arg_count) {
+    if (arg_count != 2) {
+        return pval_error("ArityError", "'/' requires exactly 2 arguments");
+    }
+    if (args[0]->type != PVAL_NUMBER || args[1]->type != PVAL_NUMBER) {
+        return pval_error("TypeError", "Arguments to / must be numbers");
+    }
+    if (args[1]->number == 0.0) {
+        return pval_error("DivisionByZeroError", "Division by zero");
+    }
+    return pval_number(args[0]->number / args[1]->number);
+}
+
+pval *builtin_eq(pval **args, int32_t arg_count) {
+    if (arg_count != 2) {
+        return pval_error("ArityError", "'=' requires exactly 2 arguments");
+    }
+
+    pval *first_arg = args[0];
+    pval *second_arg = args[1];
+
+    if (first_arg->type != second_arg->type) {
+        return pval_bool(false);
+    }
+
+    switch (first_arg->type) {
+    case PVAL_NUMBER:
+    case PVAL_BOOL:
+    case PVAL_SYMBOL:
+    case PVAL_LIST:
+    case PVAL_BYTES:
+        return pval_bool(pval_equal(first_arg, second_arg));
+    default:
+        return pval_error("TypeError", "Unsupported types for equality comparison");
+    }
+}
+
+pval *builtin_quit(pval **args, int32_t arg_count) {
+    if (arg_count != 0) {
+        return pval_error("ArityError", "quit takes no arguments");
+    }
+    return pval_symbol("quitting");
+}
+
+pval *builtin_list(pval **args, int32_t arg_count) {
+    pval *new_list = pval_list();
+    if (new_list == NULL) {
+        return pval_error("MemoryError", "Failed to allocate list");
+    }
+    for (int32_t i = 0; i < arg_count; i++) {
+        pval_add(new_list, pval_copy(args[i]));
+    }
+    return new_list;
+}
+
+static pval *wrap_promise(promise_t *promise) {
+    pval *new_value = promise == NULL ? NULL : pval_promise(promise);
+    if (new_value == NULL) {
+        if (promise != NULL) {
+            promise->ref_count = 1;
+            promise_release(promise);
+        }
+        return pval_error("MemoryError", "Failed to allocate promise");
+    }
+    return new_value;
+}
+
+// (force p) yields the value of the promise p, running its thunk only the
+// first time. The thunk is detached while it runs, so forcing p from inside
+// it is an error rather than a second evaluation; if it fails, p stays
+// unforced. Anything that is not a promise is returned as it is.
+pval *builtin_force(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "force takes exactly 1 argument");
+    }
+    if (args[0]->type != PVAL_PROMISE) {
+        return pval_copy(args[0]);
+    }
+    promise_t *promise = args[0]->promise;
+    if (promise->value == NULL) {
+        pval *thunk = promise->thunk;
+        if (thunk == NULL) {
+            return pval_error("ForceError", "Promise forced while it is being forced");
+        }
+        promise->thunk = NULL;
+        pval *value = single_value(closure_call(thunk, NULL, 0));
+        if (value == NULL || value->type == PVAL_ERROR) {
+            promise->thunk = thunk;
+            return value;
+        }
+        pval_delete(thunk);
+        promise->value = value;
+    }
+    return pval_copy(promise->value);
+}
+
+// (make-promise v) is a promise already forced to v; a promise stays as it is.
+pval *builtin_make_promise(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "make-promise takes exactly 1 argument");
+    }
+    if (args[0]->type == PVAL_PROMISE) {
+        return pval_copy(args[0]);
+    }
+    pval *value = pval_copy(args[0]);
+    if (value == NULL) {
+        return pval_error("MemoryError", "Failed to allocate promise");
+    }
+    promise_t *promise = promise_new(NULL, value);
+    if (promise == NULL) {
+        pval_delete(value);
+    }
+    return wrap_promise(promise);
+}
+
+// (memoize f) returns a copy of the lambda f with a fresh memo table;
+// (memoize f n) keeps at most n entries.
+pval *builtin_memoize(pval **args, int32_t arg_count) {
+    if (arg_count != 1 && arg_count != 2) {
+        return pval_error("ArityError", "memoize takes a lambda and an optional capacity");
+    }
+    if (args[0]->type != PVAL_CLOSURE) {
+        return pval_error("TypeError", "First argument to memoize must be a lambda");
+    }
+    int32_t capacity = 0;
+    if (arg_count == 2) {
+        if (args[1]->type != PVAL_NUMBER || args[1]->number < 1
+            || args[1]->number > INT32_MAX || args[1]->number != (int32_t)args[1]->number) {
+            return pval_error("TypeError", "memoize capacity must be a positive integer");
+        }
+        capacity = (int32_t)args[1]->number;
+    }
+
+    memo_table_t *table = memo_table_new(capacity);
+    pval *memoized = table == NULL ? NULL : pval_copy(args[0]);
+    if (memoized == NULL) {
+        memo_table_release(table);
+        return pval_error("MemoryError", "Failed to allocate memo table");
+    }
+    memo_table_release(memoized->memo);
+    memoized->memo = table;
+    return memoized;
+}
+
+// (memo-stats f) returns (hits misses entries) for a memoized lambda.
+pval *builtin_memo_stats(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "memo-stats takes exactly 1 argument");
+    }
+    if (args[0]->type != PVAL_CLOSURE || args[0]->memo == NULL) {
+        return pval_error("TypeError", "Argument to memo-stats must be a memoized lambda");
+    }
+    memo_table_t *table = args[0]->memo;
+    pval *stats = pval_list();
+    if (stats == NULL) {
+        return pval_error("MemoryError", "Failed to allocate list");
+    }
+    pval_add(stats, pval_number((double)table->hits));
+    pval_add(stats, pval_number((double)table->misses));
+    pval_add(stats, pval_number(table->entry_count));
+    return stats;
+}
+
+// Builtin Op Function Struct
+typedef struct builtin {
+    const char *name;
+    builtin_function_ptr func;
+    const char *c_name;
+    bool pure; // Result depends only on the arguments and nothing else happens
+} builtin_t;
+
+builtin_t builtins[] = {
+    {"+", builtin_add, "builtin_add", true},
+    {"-", builtin_sub, "builtin_sub", true},
+    {"*", builtin_mul, "builtin_mul", true},
+    {"/", builtin_div, "builtin_div", true},
+    {"=", builtin_eq, "builtin_eq", true},
+    {"list", builtin_list, "builtin_list", true},
+    {"force", builtin_force, "builtin_force", false},
+    {"make-promise", builtin_make_promise, "builtin_make_promise", false},
+    {"make-generator", builtin_make_generator, "builtin_make_generator", false},
+    {"yield", builtin_yield, "builtin_yield", false},
+    {"generator-done?", builtin_generator_done, "builtin_generator_done", false},
+    {"values", builtin_values, "builtin_values", false},
+    {"call-with-values", builtin_call_with_values, "builtin_call_with_values", false},
+    {"serialize", builtin_serialize, "builtin_serialize", false},
+    {"deserialize", builtin_deserialize, "builtin_deserialize", false},
+    {"write-bytes", builtin_write_bytes, "builtin_write_bytes", false},
+    {"read-bytes", builtin_read_bytes, "builtin_read_bytes", false},
+    {"quit", builtin_quit, "builtin_quit", false},
+    {"memoize", builtin_memoize, "builtin_memoize", false},
+    {"memo-stats", builtin_memo_stats, "builtin_memo_stats", false},
+    {NULL, NULL, NULL, false}
+};
+
+static builtin_function_ptr lookup_builtin(const char *name) {
+    for (int32_t i = 0; builtins[i].name != NULL; i++) {
+        if (strcmp(name, builtins[i].name) == 0) {
+            return builtins[i].func;
+        }
+    }
+    return NULL;
+}
+
+// Nesting Depth
+// Evaluation and the compile-time passes still recurse on the C stack, so
+// their nesting is capped: past max_nesting_depth nested levels they stop
+// with a RecursionError instead of overflowing the stack. --max-depth
+// changes the cap, but never past what the stack can hold at
+// NESTING_LEVEL_BYTES a level. The bytes a level takes depend on the form
+// and the build, so the stack pointer is also checked against stack_limit,
+// the lowest address nesting may reach on the stack in use, leaving
+// NESTING_STACK_RESERVE for the calls made at the deepest level. Parsing,
+// printing, copying, deleting and the numeric trace use work stacks and are
+// not limited.
+#define DEFAULT_MAX_NESTING_DEPTH 5000
+#define NESTING_LEVEL_BYTES 1024
+#define NESTING_STACK_RESERVE (256 * 1024)
+#define NESTING_STACK_MAX ((size_t)1 << 30) // Assumed for an unlimited stack
+
+static int32_t nesting_depth = 0;
+static int32_t max_nesting_depth = DEFAULT_MAX_NESTING_DEPTH;
+static char *stack_limit = NULL; // NULL when the stack's size is unknown
+
+// Sets stack_limit for the main thread's stack, whose top is near base, and
+// clamps max_nesting_depth to what it holds.
+static void nesting_stack_init(char *base) {
+    struct rlimit limit;
+    size_t size = NESTING_STACK_MAX;
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY
+        && limit.rlim_cur < size) {
+        size = (size_t)limit.rlim_cur;
+    }
+    size = size > 2 * NESTING_STACK_RESERVE ? size - NESTING_STACK_RESERVE : size / 2;
+    stack_limit = base - size;
+    if ((size_t)max_nesting_depth > size / NESTING_LEVEL_BYTES) {
+        max_nesting_depth = (int32_t)(size / NESTING_LEVEL_BYTES);
+    }
+}
+
+static bool nesting_enter(void) {
+    char here;
+    if (nesting_depth >= max_nesting_depth || (stack_limit != NULL && &here < stack_limit)) {
+        return false;
+    }
+    nesting_depth++;
+    return true;
+}
+
+static void nesting_leave(void) {
+    nesting_depth--;
+}
+
+static pval *nesting_error(void) {
+    return pval_error("RecursionError", "Maximum nesting depth exceeded");
+}
+
+// Global Environment
+// Top-level bindings made by define, defmemo and defmacro, in a chained hash
+// table that doubles its bucket count as it fills. Bindings are keyed by
+// interned name, hashed with the hash the symbol table stored and compared
+// by pointer. A symbol is looked up in
+// the current frame first, then here, then among the builtins. Builtin and
+// special form names cannot be rebound, so a call site or trace that
+// resolved a builtin never goes stale. A macro binding holds its transformer
+// and is only visible at the head of a call; every change to a macro binding
+// advances macro_generation, which retires cached expansions. A binding
+// loaded from a heap image holds the encoding of its value instead, and is
+// decoded the first time it is looked up.
+#define GLOBAL_INITIAL_BUCKETS 64
+
+typedef struct global_binding {
+    const char *name; // Interned
+    uint64_t hash;
+    pval *value;
+    bool macro;
+    struct global_binding *next;
+    const uint8_t *image_data; // Encoded value not decoded yet, or NULL
+    size_t image_length;
+} global_binding_t;
+
+static global_binding_t **global_buckets = NULL;
+static int32_t global_bucket_count = 0;
+static int32_t global_count = 0;
+static int32_t global_macro_count = 0;
+static int32_t macro_generation = 0;
+
+static global_binding_t *global_find(const char *name) {
+    if (global_count == 0) {
+        return NULL;
+    }
+    global_binding_t *binding = global_buckets[symbol_hash(name) & (global_bucket_count - 1)];
+    for (; binding != NULL; binding = binding->next) {
+        if (binding->name == name) {
+            return binding;
+        }
+    }
+    return NULL;
+}
+
+static pval *global_value(global_binding_t *binding) {
+    if (binding->image_data != NULL) {
+        binding->value = deserialize_value(binding->image_data, binding->image_length, true);
+        binding->image_data = NULL;
+        // A damaged image can hold anything under a macro's name; such a
+        // binding becomes an ordinary one holding the error.
+        if (binding->macro && (binding->value == NULL || binding->value->type != PVAL_CLOSURE)) {
+            pval_delete(binding->value);
+            binding->value = pval_error("FormatError", "Macro in image is not a lambda");
+            binding->macro = false;
+            global_macro_count--;
+            macro_generation++;
+        }
+    }
+    return binding->value;
+}
+
+static pval *global_lookup(const char *name) {
+    global_binding_t *binding = global_find(name);
+    return binding != NULL && !binding->macro ? global_value(binding) : NULL;
+}
+
+static pval *global_lookup_macro(const char *name) {
+    if (global_macro_count == 0) {
+        return NULL;
+    }
+    global_binding_t *binding = global_find(name);
+    if (binding == NULL || !binding->macro) {
+        return NULL;
+    }
+    pval *transformer = global_value(binding);
+    return binding->macro ? transformer : NULL; // Still a macro once decoded
+}
+
+static bool global_grow(void) {
+    int32_t new_count = global_bucket_count == 0 ? GLOBAL_INITIAL_BUCKETS
+                                                 : global_bucket_count * 2;
+    global_binding_t **buckets = calloc(new_count, sizeof(global_binding_t *));
+    if (buckets == NULL) {
+        return global_bucket_count > 0; // Keep the longer chains if there are any
+    }
+    for (int32_t i = 0; i < global_bucket_count; i++) {
+        global_binding_t *binding = global_buckets[i];
+        while (binding != NULL) {
+            global_binding_t *next = binding->next;
+            global_binding_t **bucket = &buckets[binding->hash & (new_count - 1)];
+            binding->next = *bucket;
+            *bucket = binding;
+            binding = next;
+        }
+    }
+    free(global_buckets);
+    global_buckets = buckets;
+    global_bucket_count = new_count;
+    return true;
+}
+
+// eval_temporary lends the values of globals to a call without copying
+// them, so a define during the call must not free the value it replaces.
+// While any value is lent, replaced values wait in retired_globals and are
+// deleted once the last loan ends.
+static int32_t global_loans = 0;
+static pval *retired_globals = NULL;
+
+static void global_retire(pval *value) {
+    if (global_loans > 0 && value != NULL) {
+        if (retired_globals == NULL) {
+            retired_globals = pval_list();
+        }
+        if (retired_globals != NULL) {
+            pval_add(retired_globals, value);
+            return;
+        }
+    }
+    pval_delete(value);
+}
+
+static void global_loan_end(void) {
+    if (--global_loans == 0 && retired_globals != NULL) {
+        pval *retired = retired_globals;
+        retired_globals = NULL; // Deleting can run code that defines again
+        pval_delete(retired);
+    }
+}
+
+// Binds name, an interned symbol name, to value, replacing any earlier
+// binding, as a macro transformer when macro is set. Takes ownership of
+// value.
+static bool global_define(const char *name, pval *value, bool macro) {
+    global_binding_t *binding = global_find(name);
+    if (binding != NULL) {
+        if (binding->macro || macro) {
+            global_macro_count += (int32_t)macro - (int32_t)binding->macro;
+            macro_generation++;
+        }
+        global_retire(binding->value);
+        binding->value = value;
+        binding->macro = macro;
+        binding->image_data = NULL;
+        return true;
+    }
+    if (global_count >= global_bucket_count && !global_grow()) {
+        return false;
+    }
+    binding = malloc(sizeof(global_binding_t));
+    if (binding == NULL) {
+        return false;
+    }
+    uint64_t hash = symbol_hash(name);
+    global_binding_t **bucket = &global_buckets[hash & (global_bucket_count - 1)];
+    *binding = (global_binding_t){name, hash, value, macro, *bucket, NULL, 0};
+    *bucket = binding;
+    global_count++;
+    if (macro) {
+        global_macro_count++;
+        macro_generation++;
+    }
+    return true;
+}
+
+// Lambdas and Closures
+// Closures are flat. The first time a lambda expression is evaluated its body
+// is scanned for free variables bound in the enclosing frame, and from then on
+// each closure copies just those values into its own capture vector instead of
+// keeping the defining environment alive. A call evaluates the body in one
+// frame holding the parameters followed by the captures, so every variable
+// access is a scan of that frame, comparing interned names by pointer.
+// Lambdas without free variables capture nothing; their closures only
+// reference the shared compiled code.
+typedef struct frame {
+    char **names;
+    pval **values;
+    int32_t count;
+} frame_t;
+
+static frame_t *current_frame = NULL;
+
+static pval *frame_lookup(const char *name) {
+    if (current_frame == NULL) {
+        return NULL;
+    }
+    for (int32_t i = 0; i < current_frame->count; i++) {
+        if (current_frame->names[i] == name) {
+            return current_frame->values[i];
+        }
+    }
+    return NULL;
+}
+
+// Variables of one lambda body are always found at the same frame position,
+// so a symbol node remembers where it was last found (as index + 1) and only
+// rescans the frame when that slot no longer holds its name.
+static pval *frame_lookup_symbol(pval *symbol_value) {
+    if (current_frame == NULL) {
+        return NULL;
+    }
+    int32_t slot = symbol_value->frame_slot - 1;
+    if (slot >= 0 && slot < current_frame->count
+        && current_frame->names[slot] == symbol_value->symbol) {
+        return current_frame->values[slot];
+    }
+    for (int32_t i = 0; i < current_frame->count; i++) {
+        if (current_frame->names[i] == symbol_value->symbol) {
+            symbol_value->frame_slot = i + 1;
+            return current_frame->values[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_form_named(pval *input_value, const char *name) {
+    return input_value->type == PVAL_LIST && input_value->list_count > 0
+        && input_value->list_items[0]->type == PVAL_SYMBOL
+        && strcmp(input_value->list_items[0]->symbol, name) == 0;
+}
+
+static bool is_lambda_form(pval *input_value) {
+    return is_form_named(input_value, "lambda");
+}
+
+static pval *macro_expansion(pval *form, pval **expand_error);
+
+static bool symbol_list_contains(pval *symbol_list, const char *name) {
+    for (int32_t i = 0; i < symbol_list->list_count; i++) {
+        if (symbol_list->list_items[i]->symbol == name) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Adds to captured every symbol of input_value that is neither bound inside
+// it nor in bound, but is bound in the current frame. Returns false if the
+// body is nested too deeply to scan.
+static bool collect_free_vars(pval *input_value, pval *bound, pval *captured) {
+    for (int32_t expansions = 0;; expansions++) {
+        if (input_value->type == PVAL_SYMBOL) {
+            if (!symbol_list_contains(bound, input_value->symbol)
+                && !symbol_list_contains(captured, input_value->symbol)
+                && frame_lookup(input_value->symbol) != NULL) {
+                pval_add(captured, pval_symbol(input_value->symbol));
+            }
+            return true;
+        }
+        if (input_value->type != PVAL_LIST || is_form_named(input_value, "quote")) {
+            return true;
+        }
+        pval *expand_error;
+        pval *expansion = macro_expansion(input_value, &expand_error);
+        pval_delete(expand_error);
+        if (expansion == NULL) {
+            break;
+        }
+        if (expansions >= max_nesting_depth) {
+            return false; // A macro that keeps expanding to macro calls
+        }
+        // The body runs the expansion, which may be a symbol or another
+        // macro call, so scan that instead.
+        input_value = expansion;
+    }
+    if (!nesting_enter()) {
+        return false;
+    }
+
+    int32_t outer_bound_count = bound->list_count;
+    int32_t first_item = 0;
+    bool scanned = true;
+    pval *params = NULL;
+    if (is_lambda_form(input_value) && input_value->list_count > 1
+        && input_value->list_items[1]->type == PVAL_LIST) {
+        params = input_value->list_items[1];
+        first_item = 2;
+    } else if (is_form_named(input_value, "receive") && input_value->list_count > 2
+               && input_value->list_items[1]->type == PVAL_LIST) {
+        // The expression giving the values is outside the scope of the formals
+        scanned = collect_free_vars(input_value->list_items[2], bound, captured);
+        params = input_value->list_items[1];
+        first_item = 3;
+    }
+    for (int32_t i = 0; params != NULL && i < params->list_count; i++) {
+        if (params->list_items[i]->type == PVAL_SYMBOL) {
+            pval_add(bound, pval_symbol(params->list_items[i]->symbol));
+        }
+    }
+    for (int32_t i = first_item; scanned && i < input_value->list_count; i++) {
+        scanned = collect_free_vars(input_value->list_items[i], bound, captured);
+    }
+    while (bound->list_count > outer_bound_count) {
+        pval_delete(bound->list_items[--bound->list_count]);
+    }
+    nesting_leave();
+    return scanned;
+}
+
+// Whether form has no compiled code yet, or code compiled before a macro
+// changed, whose captures can miss variables the new expansions use.
+static bool code_is_stale(pval *form) {
+    return form->site == NULL || form->site->code == NULL
+        || form->site->code->macro_generation != macro_generation;
+}
+
+// Compiles the items of form from first_body_item on into a body taking the
+// symbols in params (NULL for none), and caches the code on form in place of
+// any stale code.
+static pval *compile_code(pval *form, pval *params, int32_t first_body_item) {
+    int32_t param_count = params != NULL ? params->list_count : 0;
+    lambda_code_t *code = malloc(sizeof(lambda_code_t));
+    pval *bound = pval_list();
+    pval *captured = pval_list();
+    pval *body = pval_list();
+    if (code == NULL || bound == NULL || captured == NULL || body == NULL) {
+        free(code);
+        pval_delete(bound);
+        pval_delete(captured);
+        pval_delete(body);
+        return pval_error("MemoryError", "Failed to compile lambda");
+    }
+
+    for (int32_t i = 0; i < param_count; i++) {
+        pval_add(bound, pval_symbol(params->list_items[i]->symbol));
+    }
+    bool scanned = true;
+    for (int32_t i = first_body_item; scanned && i < form->list_count; i++) {
+        // Scans the copy the body will run, so macro expansions cached by the
+        // scan are reused by every call.
+        pval *body_form = pval_copy(form->list_items[i]);
+        pval_add(body, body_form);
+        scanned = body_form != NULL && collect_free_vars(body_form, bound, captured);
+    }
+    if (!scanned) {
+        free(code);
+        pval_delete(bound);
+        pval_delete(captured);
+        pval_delete(body);
+        return nesting_error();
+    }
+
+    *code = (lambda_code_t){
+        .ref_count = 1,
+        .names = malloc((param_count + captured->list_count + 1) * sizeof(char *)),
+        .param_count = param_count,
+        .capture_count = captured->list_count,
+        .body = body,
+        .macro_generation = macro_generation
+    };
+    for (int32_t i = 0; code->names != NULL && i < param_count; i++) {
+        code->names[i] = params->list_items[i]->symbol;
+    }
+    for (int32_t i = 0; code->names != NULL && i < captured->list_count; i++) {
+        code->names[param_count + i] = captured->list_items[i]->symbol;
+    }
+    pval_delete(bound);
+    pval_delete(captured);
+    if (code->names == NULL) {
+        lambda_code_release(code);
+        return pval_error("MemoryError", "Failed to compile lambda");
+    }
+    call_site_t *site = call_site_of(form);
+    if (site == NULL) {
+        lambda_code_release(code);
+        return pval_error("MemoryError", "Failed to compile lambda");
+    }
+    if (site->code != NULL) {
+        lambda_code_release(site->code); // Closures made from it keep it
+    }
+    site->code = code;
+    return NULL;
+}
+
+static pval *compile_lambda(pval *lambda_expr) {
+    if (lambda_expr->list_count < 3 || lambda_expr->list_items[1]->type != PVAL_LIST) {
+        return pval_error("SyntaxError", "lambda requires a parameter list and a body");
+    }
+    pval *params = lambda_expr->list_items[1];
+    for (int32_t i = 0; i < params->list_count; i++) {
+        if (params->list_items[i]->type != PVAL_SYMBOL) {
+            return pval_error("SyntaxError", "lambda parameters must be symbols");
+        }
+    }
+    return compile_code(lambda_expr, params, 2);
+}
+
+// Builds a closure over the code compiled for form, capturing its free
+// variables from the current frame.
+static pval *make_closure(pval *form) {
+    lambda_code_t *code = form->site->code;
+    pval **captures = NULL;
+    if (code->capture_count > 0) {
+        captures = malloc(code->capture_count * sizeof(pval *));
+        if (captures == NULL) {
+            return pval_error("MemoryError", "Failed to allocate closure");
+        }
+        for (int32_t i = 0; i < code->capture_count; i++) {
+            captures[i] = pval_copy(frame_lookup(code->names[code->param_count + i]));
+        }
+    }
+    pval *closure = pval_closure(code, captures);
+    if (closure == NULL) {
+        for (int32_t i = 0; i < code->capture_count; i++) {
+            pval_delete(captures[i]);
+        }
+        free(captures);
+        return pval_error("MemoryError", "Failed to allocate closure");
+    }
+    return closure;
+}
+
+static pval *eval_lambda(pval *lambda_expr) {
+    if (code_is_stale(lambda_expr)) {
+        pval *compile_error = compile_lambda(lambda_expr);
+        if (compile_error != NULL) {
+            return compile_error;
+        }
+    }
+    return make_closure(lambda_expr);
+}
+
+// Evaluates the body of code in a frame of args followed by captures. With
+// captures NULL the captured variables are borrowed from the current frame,
+// which must be the one code was compiled in.
+static pval *run_code(lambda_code_t *code, pval **args, pval **captures) {
+    pval *inline_values[8];
+    int32_t slot_count = code->param_count + code->capture_count;
+    pval **values = inline_values;
+    if (slot_count > 8) {
+        values = malloc(slot_count * sizeof(pval *));
+        if (values == NULL) {
+            return pval_error("MemoryError", "Failed to allocate call frame");
+        }
+    }
+    for (int32_t i = 0; i < code->param_count; i++) {
+        values[i] = args[i];
+    }
+    for (int32_t i = 0; i < code->capture_count; i++) {
+        pval *captured = captures != NULL ? captures[i]
+            : frame_lookup(code->names[code->param_count + i]);
+        if (captured == NULL) {
+            if (values != inline_values) {
+                free(values);
+            }
+            return pval_error("UnboundError", "Captured variable is not bound");
+        }
+        values[code->param_count + i] = captured;
+    }
+
+    frame_t frame = {code->names, values, slot_count};
+    frame_t *caller_frame = current_frame;
+    current_frame = &frame;
+    pval *eval_result = NULL;
+    for (int32_t i = 0; i < code->body->list_count; i++) {
+        pval_delete(eval_result);
+        eval_result = pval_eval(code->body->list_items[i]);
+        if (eval_result == NULL || eval_result->type == PVAL_ERROR) {
+            break;
+        }
+    }
+    current_frame = caller_frame;
+
+    if (values != inline_values) {
+        free(values);
+    }
+    return eval_result;
+}
+
+static pval *closure_run(pval *closure, pval **args) {
+    return run_code(closure->code, args, closure->captures);
+}
+
+// Evaluates the closure's body in a fresh frame, or answers from its memo
+// table. The arguments stay owned by the caller.
+static pval *closure_call(pval *closure, pval **args, int32_t arg_count) {
+    if (arg_count != closure->code->param_count) {
+        return pval_error("ArityError", "Wrong number of arguments to lambda");
+    }
+    memo_table_t *table = closure->memo;
+    if (table == NULL) {
+        return closure_run(closure, args);
+    }
+
+    uint64_t hash = memo_args_hash(args, arg_count);
+    pval *remembered = memo_lookup(table, hash, args, arg_count);
+    if (remembered != NULL) {
+        return pval_copy(remembered);
+    }
+    pval *eval_result = closure_run(closure, args);
+    if (eval_result != NULL && eval_result->type != PVAL_ERROR
+        && eval_result->type != PVAL_VALUES) {
+        memo_store(table, hash, args, arg_count, eval_result);
+    }
+    return eval_result;
+}
+
+// Generators
+// (make-generator f) turns a lambda without parameters into a generator.
+// Each call (g) or (g v) runs f until it calls (yield x) and returns x; the
+// next call resumes f there, with v, or (), as the value of the yield. When
+// f returns, its value is the last result and the generator is done. f runs
+// as a coroutine on its own stack, so yield works at any depth of calls
+// inside it. Stacks are reserved with mmap and committed by the kernel page
+// by page as they are touched, with a guard page below; a switch saves only
+// the callee-saved registers. The current frame and nesting depth belong to
+// each stack and are swapped with it. A generator dropped while suspended is
+// resumed once more with its yield returning a GeneratorError, so that its
+// body unwinds and frees what it holds.
+#define COROUTINE_STACK_SIZE (8 * 1024 * 1024)
+
+#ifndef MAP_NORESERVE
+#define MAP_NORESERVE 0
+#endif
+
+static generator_t *current_generator = NULL;
+
+#ifdef COROUTINE_USE_UCONTEXT
+static generator_t *starting_generator = NULL;
+#else
+#if defined(__APPLE__)
+#define COROUTINE_SYMBOL(name) "_" #name
+#else
+#define COROUTINE_SYMBOL(name) #name
+#endif
+
+// Saves the callee-saved registers on the current stack, stores the stack
+// pointer in *save_sp, then switches to load_sp and restores from there.
+void psi_switch_context(void **save_sp, void *load_sp);
+// First code run on a new stack: calls the entry function with its argument,
+// which were placed in callee-saved registers.
+void psi_coroutine_start(void);
+
+#if defined(__x86_64__)
+#define COROUTINE_SAVED_SLOTS 7
+__asm__(
+    ".text\n"
+    ".p2align 4\n"
+    COROUTINE_SYMBOL(psi_switch_context) ":\n"
+    "    pushq %rbp\n"
+    "    pushq %rbx\n"
+    "    pushq %r12\n"
+    "    pushq %r13\n"
+    "    pushq %r14\n"
+    "    pushq %r15\n"
+    "    movq %rsp, (%rdi)\n"
+    "    movq %rsi, %rsp\n"
+    "    popq %r15\n"
+    "    popq %r14\n"
+    "    popq %r13\n"
+    "    popq %r12\n"
+    "    popq %rbx\n"
+    "    popq %rbp\n"
+    "    ret\n"
+    ".p2align 4\n"
+    COROUTINE_SYMBOL(psi_coroutine_start) ":\n"
+    "    movq %rbx, %rdi\n"
+    "    callq *%r12\n"
+    "    ud2\n");
+
+static void coroutine_init_stack(void **slots, void (*entry)(generator_t *), generator_t *arg) {
+    slots[3] = (void *)entry;              // r12
+    slots[4] = arg;                        // rbx
+    slots[6] = (void *)psi_coroutine_start; // return address
+}
+#else
+#define COROUTINE_SAVED_SLOTS 20
+__asm__(
+    ".text\n"
+    ".p2align 4\n"
+    COROUTINE_SYMBOL(psi_switch_context) ":\n"
+    "    sub sp, sp, #160\n"
+    "    stp x19, x20, [sp, #0]\n"
+    "    stp x21, x22, [sp, #16]\n"
+    "    stp x23, x24, [sp, #32]\n"
+    "    stp x25, x26, [sp, #48]\n"
+    "    stp x27, x28, [sp, #64]\n"
+    "    stp x29, x30, [sp, #80]\n"
+    "    stp d8, d9, [sp, #96]\n"
+    "    stp d10, d11, [sp, #112]\n"
+    "    stp d12, d13, [sp, #128]\n"
+    "    stp d14, d15, [sp, #144]\n"
+    "    mov x2, sp\n"
+    "    str x2, [x0]\n"
+    "    mov sp, x1\n"
+    "    ldp x19, x20, [sp, #0]\n"
+    "    ldp x21, x22, [sp, #16]\n"
+    "    ldp x23, x24, [sp, #32]\n"
+    "    ldp x25, x26, [sp, #48]\n"
+    "    ldp x27, x28, [sp, #64]\n"
+    "    ldp x29, x30, [sp, #80]\n"
+    "    ldp d8, d9, [sp, #96]\n"
+    "    ldp d10, d11, [sp, #112]\n"
+    "    ldp d12, d13, [sp, #128]\n"
+    "    ldp d14, d15, [sp, #144]\n"
+    "    add sp, sp, #160\n"
+    "    ret\n"
+    ".p2align 4\n"
+    COROUTINE_SYMBOL(psi_coroutine_start) ":\n"
+    "    mov x0, x19\n"
+    "    blr x20\n"
+    "    brk #0\n");
+
+static void coroutine_init_stack(void **slots, void (*entry)(generator_t *), generator_t *arg) {
+    slots[0] = arg;                         // x19
+    slots[1] = (void *)entry;               // x20
+    slots[11] = (void *)psi_coroutine_start; // x30
+}
+#endif
+#endif
+
+static void generator_entry(generator_t *generator);
+
+#ifdef COROUTINE_USE_UCONTEXT
+static void generator_entry_ucontext(void) {
+    generator_entry(starting_generator);
+}
+#endif
+
+static void coroutine_switch(coroutine_context_t *from, coroutine_context_t *to) {
+#ifdef COROUTINE_USE_UCONTEXT
+    swapcontext(from, to);
+#else
+    psi_switch_context(from, *to);
+#endif
+}
+
+// Maps the generator's stack and arranges for the first switch to it to
+// enter generator_entry.
+static bool coroutine_prepare(generator_t *generator) {
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    char *stack = mmap(NULL, COROUTINE_STACK_SIZE, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (stack == MAP_FAILED) {
+        return false;
+    }
+    mprotect(stack, page_size, PROT_NONE);
+    generator->stack = stack;
+#ifdef COROUTINE_USE_UCONTEXT
+    getcontext(&generator->context);
+    generator->context.uc_stack.ss_sp = stack + page_size;
+    generator->context.uc_stack.ss_size = COROUTINE_STACK_SIZE - page_size;
+    generator->context.uc_link = NULL;
+    makecontext(&generator->context, generator_entry_ucontext, 0);
+#else
+    uintptr_t top = ((uintptr_t)(stack + COROUTINE_STACK_SIZE) & ~(uintptr_t)15) - 16;
+    void **slots = (void **)top - COROUTINE_SAVED_SLOTS;
+    memset(slots, 0, COROUTINE_SAVED_SLOTS * sizeof(void *));
+    coroutine_init_stack(slots, generator_entry, generator);
+    generator->context = slots;
+#endif
+    return true;
+}
+
+void generator_entry(generator_t *generator) {
+    pval_delete(generator->transfer); // Sent by the first resume, with no yield to receive it
+    generator->transfer = closure_call(generator->body, NULL, 0);
+    generator->finished = true;
+    coroutine_switch(&generator->context, &generator->caller_context);
+    abort(); // A finished generator is never resumed
+}
+
+// Runs the generator until it yields or finishes, with sent (owned, or NULL
+// when cancelling) as the value of the pending yield.
+static pval *generator_resume(generator_t *generator, pval *sent) {
+    if (!generator->started && !coroutine_prepare(generator)) {
+        pval_delete(sent);
+        return pval_error("MemoryError", "Failed to allocate generator stack");
+    }
+    if (!generator->started) {
+        // The body runs inside the resuming call, never at top level, so
+        // defmacro is rejected there as in any other nested evaluation.
+        generator->depth = nesting_depth;
+    }
+    generator->started = true;
+    generator->transfer = sent;
+
+    frame_t *caller_frame = current_frame;
+    int32_t caller_depth = nesting_depth;
+    char *caller_stack_limit = stack_limit;
+    generator_t *caller_generator = current_generator;
+    current_frame = generator->frame;
+    nesting_depth = generator->depth;
+    stack_limit = generator->stack + (size_t)sysconf(_SC_PAGESIZE) + NESTING_STACK_RESERVE;
+    current_generator = generator;
+    generator->running = true;
+#ifdef COROUTINE_USE_UCONTEXT
+    starting_generator = generator;
+#endif
+    coroutine_switch(&generator->caller_context, &generator->context);
+    generator->running = false;
+    current_frame = caller_frame;
+    nesting_depth = caller_depth;
+    stack_limit = caller_stack_limit;
+    current_generator = caller_generator;
+
+    pval *result = generator->transfer;
+    generator->transfer = NULL;
+    if (generator->finished) {
+        munmap(generator->stack, COROUTINE_STACK_SIZE);
+        generator->stack = NULL;
+    }
+    return result;
+}
+
+static pval *generator_call(generator_t *generator, pval **args, int32_t arg_count) {
+    if (arg_count > 1) {
+        return pval_error("ArityError", "A generator takes at most 1 argument");
+    }
+    if (generator->finished) {
+        return pval_error("GeneratorError", "Generator is exhausted");
+    }
+    if (generator->running) {
+        return pval_error("GeneratorError", "Generator is already running");
+    }
+    pval *sent = arg_count == 1 ? pval_copy(args[0]) : pval_list();
+    if (sent == NULL) {
+        return pval_error("MemoryError", "Failed to resume generator");
+    }
+    pval *result = generator_resume(generator, sent);
+    return result != NULL ? result : pval_error("EvalError", "Null evaluation result");
+}
+
+void generator_release(generator_t *generator) {
+    if (--generator->ref_count > 0) {
+        return;
+    }
+    if (generator->started && !generator->finished) {
+        generator->ref_count = 1; // Held by the cancelling resume
+        generator->cancelled = true;
+        pval_delete(generator_resume(generator, NULL));
+        if (--generator->ref_count > 0) {
+            return; // Stored somewhere while unwinding
+        }
+    }
+    pval_delete(generator->body);
+    pval_delete(generator->transfer);
+    free(generator);
+}
+
+pval *builtin_make_generator(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "make-generator takes exactly 1 argument");
+    }
+    if (args[0]->type != PVAL_CLOSURE || args[0]->code->param_count != 0) {
+        return pval_error("TypeError", "make-generator requires a lambda without parameters");
+    }
+    generator_t *generator = calloc(1, sizeof(generator_t));
+    pval *body = generator == NULL ? NULL : pval_copy(args[0]);
+    pval *new_value = body == NULL ? NULL : pval_generator(generator);
+    if (new_value == NULL) {
+        pval_delete(body);
+        free(generator);
+        return pval_error("MemoryError", "Failed to allocate generator");
+    }
+    generator->body = body;
+    return new_value;
+}
+
+// Suspends the running generator and returns the value it is resumed with.
+pval *builtin_yield(pval **args, int32_t arg_count) {
+    if (arg_count > 1) {
+        return pval_error("ArityError", "yield takes at most 1 argument");
+    }
+    generator_t *generator = current_generator;
+    if (generator == NULL) {
+        return pval_error("GeneratorError", "yield outside of a generator");
+    }
+    if (generator->cancelled) {
+        return pval_error("GeneratorError", "Generator cancelled");
+    }
+    generator->transfer = arg_count == 1 ? pval_copy(args[0]) : pval_list();
+    generator->frame = current_frame;
+    generator->depth = nesting_depth;
+    coroutine_switch(&generator->context, &generator->caller_context);
+    pval *sent = generator->transfer;
+    generator->transfer = NULL;
+    return sent != NULL ? sent : pval_error("GeneratorError", "Generator cancelled");
+}
+
+pval *builtin_generator_done(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "generator-done? takes exactly 1 argument");
+    }
+    if (args[0]->type != PVAL_GENERATOR) {
+        return pval_error("TypeError", "Argument to generator-done? must be a generator");
+    }
+    return pval_bool(args[0]->generator->finished);
+}
+
+// Function Application
+// Applies an already evaluated expression: the head must be a function and
+// the remaining items are its arguments. The first error among the items is
+// propagated instead. The items are only read, never kept.
+static pval *apply_items(pval **evaluated_items, int32_t item_count) {
+    pval *eval_result = NULL;
+    for (int32_t i = 0; i < item_count && eval_result == NULL; i++) {
+        if (evaluated_items[i] == NULL) {
+            eval_result = pval_error("EvalError", "Null evaluation result");
+        } else if (evaluated_items[i]->type == PVAL_ERROR) {
+            eval_result = pval_error(evaluated_items[i]->error_type,
+                                     evaluated_items[i]->error_message);
+        } else if (evaluated_items[i]->type == PVAL_VALUES) {
+            eval_result = values_error();
+        }
+    }
+    if (eval_result == NULL) {
+        pval *function_head = evaluated_items[0];
+        if (function_head->type == PVAL_FUNCTION) {
+            eval_result = function_head->function(evaluated_items + 1, item_count - 1);
+        } else if (function_head->type == PVAL_CLOSURE) {
+            eval_result = closure_call(function_head, evaluated_items + 1, item_count - 1);
+        } else if (function_head->type == PVAL_GENERATOR) {
+            eval_result = generator_call(function_head->generator, evaluated_items + 1,
+                                         item_count - 1);
+        } else {
+            eval_result = pval_error("InapplicableHeadError",
+                                     "Expression head is not a function");
+        }
+    }
+    return eval_result;
+}
+
+// Same as apply_items, but consumes the items whatever the outcome; the array
+// itself stays owned by the caller.
+pval *pval_apply(pval **evaluated_items, int32_t item_count) {
+    pval *eval_result = apply_items(evaluated_items, item_count);
+    for (int32_t i = 0; i < item_count; i++) {
+        pval_delete(evaluated_items[i]);
+    }
+    return eval_result;
+}
+
+// Multiple Values
+// (values a b ...) hands several results to its continuation without building
+// a list: copies of the arguments go into value_registers and the call
+// yields values_token, a static marker meaning "the results are in the
+// registers". call-with-values and receive move them from there onto the C
+// stack and bind them as arguments. The token passes through returns, tail
+// positions and generator results unchanged, but only one set of values is
+// in flight at a time: the next call of values, or deleting the token,
+// discards them. Any other context that takes one value reports a
+// ValuesError, and (values x) is just x.
+static pval *values_error(void) {
+    return pval_error("ValuesError", "Multiple values where one value is expected");
+}
+
+void values_release(void) {
+    while (value_count > 0) {
+        pval_delete(value_registers[--value_count]);
+    }
+}
+
+// Turns multiple values reaching a context that takes one value into an
+// error; any other value is returned as it is.
+static pval *single_value(pval *value) {
+    if (value != &values_token) {
+        return value;
+    }
+    values_release();
+    return values_error();
+}
+
+// Moves the results of an evaluation into values, which has room for
+// MAX_VALUES, and returns their count. Consumes result.
+static int32_t values_take(pval *result, pval **values) {
+    if (result != &values_token) {
+        values[0] = result;
+        return 1;
+    }
+    int32_t count = value_count;
+    memcpy(values, value_registers, count * sizeof(pval *));
+    value_count = 0;
+    return count;
+}
+
+pval *builtin_values(pval **args, int32_t arg_count) {
+    if (arg_count == 1) {
+        return pval_copy(args[0]);
+    }
+    if (arg_count > MAX_VALUES) {
+        return pval_error("ArityError", "values takes at most 64 arguments");
+    }
+    values_release();
+    for (int32_t i = 0; i < arg_count; i++) {
+        value_registers[i] = pval_copy(args[i]);
+        if (value_registers[i] == NULL) {
+            values_release();
+            return pval_error("MemoryError", "Failed to copy values");
+        }
+        value_count++;
+    }
+    return &values_token;
+}
+
+// (call-with-values producer consumer) calls producer without arguments and
+// applies consumer to the values it returns.
+pval *builtin_call_with_values(pval **args, int32_t arg_count) {
+    if (arg_count != 2) {
+        return pval_error("ArityError", "call-with-values takes exactly 2 arguments");
+    }
+    pval *produced = apply_items(args, 1);
+    if (produced == NULL || produced->type == PVAL_ERROR) {
+        return produced;
+    }
+    pval *items[MAX_VALUES + 1];
+    items[0] = args[1];
+    int32_t count = values_take(produced, items + 1);
+    pval *eval_result = apply_items(items, count + 1);
+    for (int32_t i = 1; i <= count; i++) {
+        pval_delete(items[i]);
+    }
+    return eval_result;
+}
+
+// Binary Serialization
+// (serialize v) encodes data as bytes that (deserialize bytes) turns back
+// into an equal value without parsing text. The encoding is the magic "PSIB"
+// and a version byte, followed by one value. Each value is a tag byte and its
+// payload: booleans have none, an integer of magnitude up to 2^53 is a
+// zigzag varint, any other number is its eight bytes, little-endian, a list
+// is its item count as a varint followed by the items, and a byte string is
+// its length and its bytes. A symbol is spelled out, length first, the first
+// time it occurs, which also gives it the next index in the symbol table;
+// later occurrences are just that index. Both directions are one pass over
+// the value with a work stack, and decoding reads every byte once.
+// Heap images also encode code: a lambda is its parameter and capture names
+// followed by its body and captures, a promise its value or thunk, and a
+// builtin or an error its name or text. serialize and deserialize only
+// accept data. Generators cannot be encoded at all.
+#define SERIAL_VERSION 1
+
+enum {
+    SERIAL_FALSE,
+    SERIAL_TRUE,
+    SERIAL_INTEGER,
+    SERIAL_DOUBLE,
+    SERIAL_SYMBOL_NEW,
+    SERIAL_SYMBOL,
+    SERIAL_LIST,
+    SERIAL_BYTES,
+    SERIAL_CLOSURE,
+    SERIAL_PROMISE,
+    SERIAL_FUNCTION,
+    SERIAL_ERROR
+};
+
+static const uint8_t serial_magic[4] = {'P', 'S', 'I', 'B'};
+
+// Output of serialize, and the table from each symbol name written so far
+// to its index, open addressed by the name's hash.
+typedef struct serial_writer {
+    uint8_t *data;
+    size_t length;
+    size_t capacity;
+    char **symbol_names;
+    uint32_t *symbol_indexes;
+    uint32_t symbol_slots;
+    uint32_t symbol_count;
+    bool with_code;
+    bool failed;
+} serial_writer_t;
+
+static void serial_put(serial_writer_t *writer, const void *bytes, size_t length) {
+    if (writer->capacity - writer->length < length) {
+        size_t new_capacity = writer->capacity > 0 ? writer->capacity : 64;
+        while (new_capacity - writer->length < length && new_capacity <= SIZE_MAX / 2) {
+            new_capacity *= 2;
+        }
+        uint8_t *grown = new_capacity - writer->length >= length
+            ? realloc(writer->data, new_capacity) : NULL;
+        if (grown == NULL) {
+            writer->failed = true;
+            return;
+        }
+        writer->data = grown;
+        writer->capacity = new_capacity;
+    }
+    memcpy(writer->data + writer->length, bytes, length);
+    writer->length += length;
+}
+
+static void serial_put_tag(serial_writer_t *writer, uint8_t tag) {
+    serial_put(writer, &tag, 1);
+}
+
+static void serial_put_varint(serial_writer_t *writer, uint64_t value) {
+    uint8_t encoded[10];
+    size_t length = 0;
+    while (value >= 0x80) {
+        encoded[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    encoded[length++] = (uint8_t)value;
+    serial_put(writer, encoded, length);
+}
+
+static void serial_put_text(serial_writer_t *writer, const char *text) {
+    size_t length = strlen(text);
+    serial_put_varint(writer, length);
+    serial_put(writer, text, length);
+}
+
+static void serial_put_number(serial_writer_t *writer, double number) {
+    if (fabs(number) <= 9007199254740992.0 && number == (double)(int64_t)number
+        && !(number == 0.0 && signbit(number))) {
+        int64_t integer = (int64_t)number;
+        serial_put_tag(writer, SERIAL_INTEGER);
+        serial_put_varint(writer, ((uint64_t)integer << 1) ^ (uint64_t)(integer >> 63));
+        return;
+    }
+    uint64_t bits;
+    memcpy(&bits, &number, sizeof(bits));
+    uint8_t encoded[9] = {SERIAL_DOUBLE};
+    for (int32_t i = 0; i < 8; i++) {
+        encoded[1 + i] = (uint8_t)(bits >> (8 * i));
+    }
+    serial_put(writer, encoded, sizeof(encoded));
+}
+
+// Doubles the symbol table, or makes its first slots.
+static bool serial_symbols_grow(serial_writer_t *writer) {
+    uint32_t new_slots = writer->symbol_slots == 0 ? 64 : writer->symbol_slots * 2;
+    char **names = calloc(new_slots, sizeof(char *));
+    uint32_t *indexes = malloc(new_slots * sizeof(uint32_t));
+    if (names == NULL || indexes == NULL) {
+        free(names);
+        free(indexes);
+        return false;
+    }
+    for (uint32_t i = 0; i < writer->symbol_slots; i++) {
+        char *name = writer->symbol_names[i];
+        if (name == NULL) {
+            continue;
+        }
+        uint32_t slot = (uint32_t)symbol_hash(name) & (new_slots - 1);
+        while (names[slot] != NULL) {
+            slot = (slot + 1) & (new_slots - 1);
+        }
+        names[slot] = name;
+        indexes[slot] = writer->symbol_indexes[i];
+    }
+    free(writer->symbol_names);
+    free(writer->symbol_indexes);
+    writer->symbol_names = names;
+    writer->symbol_indexes = indexes;
+    writer->symbol_slots = new_slots;
+    return true;
+}
+
+static void serial_put_symbol(serial_writer_t *writer, char *name) {
+    if (2 * (writer->symbol_count + 1) > writer->symbol_slots && !serial_symbols_grow(writer)) {
+        writer->failed = true;
+        return;
+    }
+    uint32_t mask = writer->symbol_slots - 1;
+    uint32_t slot = (uint32_t)symbol_hash(name) & mask;
+    while (writer->symbol_names[slot] != NULL) {
+        if (writer->symbol_names[slot] == name) {
+            serial_put_tag(writer, SERIAL_SYMBOL);
+            serial_put_varint(writer, writer->symbol_indexes[slot]);
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+    writer->symbol_names[slot] = name;
+    writer->symbol_indexes[slot] = writer->symbol_count++;
+    serial_put_tag(writer, SERIAL_SYMBOL_NEW);
+    serial_put_text(writer, name);
+}
+
+// Writes the tag and payload of target_value and returns how many values
+// follow it as its items, or -1 if it cannot be encoded.
+static int32_t serial_put_header(serial_writer_t *writer, pval *target_value) {
+    switch (target_value->type) {
+    case PVAL_NUMBER:
+        serial_put_number(writer, target_value->number);
+        return 0;
+    case PVAL_BOOL:
+        serial_put_tag(writer, target_value->boolean ? SERIAL_TRUE : SERIAL_FALSE);
+        return 0;
+    case PVAL_SYMBOL:
+        serial_put_symbol(writer, target_value->symbol);
+        return 0;
+    case PVAL_BYTES:
+        serial_put_tag(writer, SERIAL_BYTES);
+        serial_put_varint(writer, target_value->bytes->length);
+        serial_put(writer, target_value->bytes->data, target_value->bytes->length);
+        return 0;
+    case PVAL_LIST:
+        serial_put_tag(writer, SERIAL_LIST);
+        serial_put_varint(writer, (uint64_t)target_value->list_count);
+        return target_value->list_count;
+    default:
+        break;
+    }
+    if (!writer->with_code) {
+        return -1;
+    }
+    switch (target_value->type) {
+    case PVAL_CLOSURE: {
+        lambda_code_t *code = target_value->code;
+        serial_put_tag(writer, SERIAL_CLOSURE);
+        serial_put_varint(writer, (uint64_t)code->param_count);
+        serial_put_varint(writer, (uint64_t)code->capture_count);
+        for (int32_t i = 0; i < code->param_count + code->capture_count; i++) {
+            serial_put_text(writer, code->names[i]);
+        }
+        // 0 without a memo table, otherwise its capacity plus one.
+        memo_table_t *memo = target_value->memo;
+        serial_put_varint(writer, memo == NULL ? 0 : (uint64_t)memo->capacity + 1);
+        return 1 + code->capture_count;
+    }
+    case PVAL_PROMISE: {
+        promise_t *promise = target_value->promise;
+        if (promise->value == NULL && promise->thunk == NULL) {
+            return -1; // Being forced
+        }
+        serial_put_tag(writer, SERIAL_PROMISE);
+        serial_put_tag(writer, promise->value != NULL);
+        return 1;
+    }
+    case PVAL_FUNCTION:
+        for (int32_t i = 0; builtins[i].name != NULL; i++) {
+            if (builtins[i].func == target_value->function) {
+                serial_put_tag(writer, SERIAL_FUNCTION);
+                serial_put_text(writer, builtins[i].name);
+                return 0;
+            }
+        }
+        return -1;
+    case PVAL_ERROR:
+        serial_put_tag(writer, SERIAL_ERROR);
+        serial_put_text(writer, target_value->error_type);
+        serial_put_text(writer, target_value->error_message);
+        return 0;
+    default:
+        return -1;
+    }
+}
+
+// Item index of the values encoded after the header of node.
+static pval *serial_item(pval *node, int32_t index) {
+    switch (node->type) {
+    case PVAL_CLOSURE:
+        return index == 0 ? node->code->body : node->captures[index - 1];
+    case PVAL_PROMISE:
+        return node->promise->value != NULL ? node->promise->value : node->promise->thunk;
+    default:
+        return node->list_items[index];
+    }
+}
+
+typedef struct serial_frame {
+    pval *node;
+    int32_t next_item;
+    int32_t item_count;
+} serial_frame_t;
+
+// Encodes target_value, code included when with_code is set. Returns the
+// encoding, or NULL with *unsupported set when a value cannot be encoded,
+// or NULL alone when out of memory.
+static byte_string_t *serialize_bytes(pval *target_value, bool with_code, bool *unsupported) {
+    serial_writer_t writer = {.with_code = with_code};
+    serial_put(&writer, serial_magic, sizeof(serial_magic));
+    serial_put_tag(&writer, SERIAL_VERSION);
+
+    *unsupported = false;
+    work_stack_t open_nodes;
+    work_stack_init(&open_nodes, sizeof(serial_frame_t));
+    while (target_value != NULL && !writer.failed) {
+        int32_t item_count = serial_put_header(&writer, target_value);
+        if (item_count < 0) {
+            *unsupported = true;
+            break;
+        }
+        if (item_count > 0) {
+            serial_frame_t *frame = work_stack_push(&open_nodes);
+            if (frame == NULL) {
+                writer.failed = true;
+                break;
+            }
+            *frame = (serial_frame_t){target_value, 0, item_count};
+        }
+
+        // Move on to the next item of the innermost unfinished node.
+        target_value = NULL;
+        while (open_nodes.count > 0) {
+            serial_frame_t *frame = work_stack_top(&open_nodes);
+            if (frame->next_item < frame->item_count) {
+                target_value = serial_item(frame->node, frame->next_item++);
+                break;
+            }
+            open_nodes.count--;
+        }
+    }
+    work_stack_free(&open_nodes);
+    free(writer.symbol_names);
+    free(writer.symbol_indexes);
+
+    byte_string_t *bytes = NULL;
+    if (!*unsupported && !writer.failed) {
+        bytes = byte_string_new(writer.data, writer.length);
+    }
+    free(writer.data);
+    return bytes;
+}
+
+// Encodes the data target_value, returning bytes or an error.
+static pval *serialize_value(pval *target_value) {
+    bool unsupported;
+    byte_string_t *bytes = serialize_bytes(target_value, false, &unsupported);
+    if (unsupported) {
+        return pval_error("TypeError", "serialize only accepts numbers, booleans, symbols, "
+                                       "bytes and lists of them");
+    }
+    pval *encoded = bytes == NULL ? NULL : pval_bytes(bytes);
+    if (encoded == NULL) {
+        free(bytes);
+        return pval_error("MemoryError", "Failed to allocate serialized bytes");
+    }
+    return encoded;
+}
+
+// Input of deserialize, and the names of the symbols read so far.
+typedef struct serial_reader {
+    const uint8_t *next;
+    const uint8_t *end;
+    char **symbols;
+    uint32_t symbol_count;
+    uint32_t symbol_capacity;
+    bool with_code;
+} serial_reader_t;
+
+static bool serial_get_varint(serial_reader_t *reader, uint64_t *value) {
+    uint64_t result = 0;
+    for (int32_t shift = 0; shift < 64 && reader->next < reader->end; shift += 7) {
+        uint8_t byte = *reader->next++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (byte < 0x80) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Reads a length and that many bytes into a new NUL-terminated string.
+// Returns NULL, with *failure set, if the input ends first or memory does.
+static char *serial_get_text(serial_reader_t *reader, const char **failure) {
+    uint64_t length;
+    if (!serial_get_varint(reader, &length)
+        || length > (uint64_t)(reader->end - reader->next)) {
+        *failure = "Malformed serialized data";
+        return NULL;
+    }
+    char *text = malloc(length + 1);
+    if (text == NULL) {
+        *failure = "Out of memory";
+        return NULL;
+    }
+    memcpy(text, reader->next, length);
+    text[length] = '\0';
+    reader->next += length;
+    return text;
+}
+
+// Reads a length and that many bytes as an interned symbol name. Returns
+// NULL, with *failure set, if the input ends first or memory does.
+static char *serial_get_name(serial_reader_t *reader, const char **failure) {
+    uint64_t length;
+    if (!serial_get_varint(reader, &length)
+        || length > (uint64_t)(reader->end - reader->next)) {
+        *failure = "Malformed serialized data";
+        return NULL;
+    }
+    char *name = symbol_intern((const char *)reader->next, length);
+    if (name == NULL) {
+        *failure = "Out of memory";
+        return NULL;
+    }
+    reader->next += length;
+    return name;
+}
+
+// A list, lambda or promise whose items are still being decoded. The items
+// of a lambda or promise are gathered in a list until they are complete.
+typedef struct deserial_frame {
+    pval *list;
+    uint64_t remaining;
+    uint8_t tag;
+    lambda_code_t *code;
+    int64_t memo_capacity; // -1 without a memo table
+    bool forced;
+} deserial_frame_t;
+
+// Starts decoding a value with items: makes the list that will gather them,
+// with room for count, and fills in frame.
+static pval *serial_open(deserial_frame_t *frame, uint8_t tag, uint64_t count,
+                         const char **failure) {
+    pval *list = pval_list();
+    if (list != NULL && count > (uint64_t)list->list_capacity) {
+        pval **items = realloc(list->list_items, count * sizeof(pval *));
+        if (items == NULL) {
+            pval_delete(list);
+            list = NULL;
+        } else {
+            list->list_items = items;
+            list->list_capacity = (int32_t)count;
+        }
+    }
+    if (list == NULL) {
+        *failure = "Out of memory";
+        return NULL;
+    }
+    *frame = (deserial_frame_t){list, count, tag, NULL, -1, false};
+    return list;
+}
+
+static pval *serial_get_closure(serial_reader_t *reader, deserial_frame_t *frame,
+                                const char **failure) {
+    uint64_t param_count, capture_count, memo;
+    if (!serial_get_varint(reader, &param_count) || !serial_get_varint(reader, &capture_count)
+        || param_count > (uint64_t)(reader->end - reader->next)
+        || capture_count > (uint64_t)(reader->end - reader->next)) {
+        *failure = "Malformed serialized data";
+        return NULL;
+    }
+    lambda_code_t *code = malloc(sizeof(lambda_code_t));
+    char **names = malloc((param_count + capture_count + 1) * sizeof(char *));
+    if (code == NULL || names == NULL) {
+        free(code);
+        free(names);
+        *failure = "Out of memory";
+        return NULL;
+    }
+    *code = (lambda_code_t){.names = names};
+    for (uint64_t i = 0; i < param_count + capture_count; i++) {
+        names[i] = serial_get_name(reader, failure);
+        if (names[i] == NULL) {
+            lambda_code_release(code);
+            return NULL;
+        }
+    }
+    code->param_count = (int32_t)param_count;
+    code->capture_count = (int32_t)capture_count;
+    if (!serial_get_varint(reader, &memo) || memo > (uint64_t)INT32_MAX + 1) {
+        lambda_code_release(code);
+        *failure = "Malformed serialized data";
+        return NULL;
+    }
+    pval *list = serial_open(frame, SERIAL_CLOSURE, 1 + capture_count, failure);
+    if (list == NULL) {
+        lambda_code_release(code);
+        return NULL;
+    }
+    frame->code = code;
+    frame->memo_capacity = (int64_t)memo - 1;
+    return list;
+}
+
+// Decodes one value without items, or starts one with items and returns
+// the list gathering them after filling in frame. frame->remaining stays 0
+// otherwise. Returns NULL for bytes that are not a value and sets *failure.
+static pval *serial_get_value(serial_reader_t *reader, deserial_frame_t *frame,
+                              const char **failure) {
+    frame->remaining = 0;
+    if (reader->next == reader->end) {
+        *failure = "Truncated serialized data";
+        return NULL;
+    }
+    uint8_t tag = *reader->next++;
+    if (tag >= SERIAL_CLOSURE && !reader->with_code) {
+        *failure = "Malformed serialized data";
+        return NULL;
+    }
+    uint64_t length;
+    switch (tag) {
+    case SERIAL_FALSE:
+    case SERIAL_TRUE:
+        return pval_bool(tag == SERIAL_TRUE);
+    case SERIAL_INTEGER:
+        if (!serial_get_varint(reader, &length)) {
+            break;
+        }
+        return pval_number((double)(int64_t)((length >> 1) ^ (0 - (length & 1))));
+    case SERIAL_DOUBLE: {
+        if (reader->end - reader->next < 8) {
+            break;
+        }
+        uint64_t bits = 0;
+        for (int32_t i = 0; i < 8; i++) {
+            bits |= (uint64_t)reader->next[i] << (8 * i);
+        }
+        reader->next += 8;
+        double number;
+        memcpy(&number, &bits, sizeof(number));
+        return pval_number(number);
+    }
+    case SERIAL_SYMBOL_NEW: {
+        if (!serial_get_varint(reader, &length) || length == 0
+            || length > (uint64_t)(reader->end - reader->next)) {
+            break;
+        }
+        if (reader->symbol_count == reader->symbol_capacity) {
+            uint32_t new_capacity = reader->symbol_capacity == 0 ? 64 : reader->symbol_capacity * 2;
+            char **grown = realloc(reader->symbols, new_capacity * sizeof(char *));
+            if (grown == NULL) {
+                *failure = "Out of memory";
+                return NULL;
+            }
+            reader->symbols = grown;
+            reader->symbol_capacity = new_capacity;
+        }
+        char *name = symbol_intern((const char *)reader->next, length);
+        if (name == NULL) {
+            *failure = "Out of memory";
+            return NULL;
+        }
+        reader->next += length;
+        reader->symbols[reader->symbol_count++] = name;
+        return pval_symbol_interned(name);
+    }
+    case SERIAL_SYMBOL:
+        if (!serial_get_varint(reader, &length) || length >= reader->symbol_count) {
+            break;
+        }
+        return pval_symbol_interned(reader->symbols[length]);
+    case SERIAL_LIST:
+        // Every item takes at least a byte, which bounds the count.
+        if (!serial_get_varint(reader, &length) || length > INT32_MAX
+            || length > (uint64_t)(reader->end - reader->next)) {
+            break;
+        }
+        return serial_open(frame, SERIAL_LIST, length, failure);
+    case SERIAL_BYTES: {
+        if (!serial_get_varint(reader, &length)
+            || length > (uint64_t)(reader->end - reader->next)) {
+            break;
+        }
+        byte_string_t *bytes = byte_string_new(reader->next, length);
+        pval *decoded = bytes == NULL ? NULL : pval_bytes(bytes);
+        if (decoded == NULL) {
+            free(bytes);
+            *failure = "Out of memory";
+            return NULL;
+        }
+        reader->next += length;
+        return decoded;
+    }
+    case SERIAL_CLOSURE:
+        return serial_get_closure(reader, frame, failure);
+    case SERIAL_PROMISE: {
+        if (reader->next == reader->end || *reader->next > 1) {
+            break;
+        }
+        bool forced = *reader->next++;
+        pval *list = serial_open(frame, SERIAL_PROMISE, 1, failure);
+        frame->forced = forced;
+        return list;
+    }
+    case SERIAL_FUNCTION: {
+        char *name = serial_get_text(reader, failure);
+        if (name == NULL) {
+            return NULL;
+        }
+        builtin_function_ptr function = lookup_builtin(name);
+        free(name);
+        if (function == NULL) {
+            *failure = "Unknown builtin in serialized data";
+            return NULL;
+        }
+        return pval_function(function);
+    }
+    case SERIAL_ERROR: {
+        char *error_type = serial_get_text(reader, failure);
+        char *error_message = error_type == NULL ? NULL : serial_get_text(reader, failure);
+        pval *decoded = error_message == NULL ? NULL : pval_error(error_type, error_message);
+        free(error_type);
+        free(error_message);
+        return decoded;
+    }
+    }
+    *failure = "Malformed serialized data";
+    return NULL;
+}
+
+// Turns the completed items of frame into the value they belong to.
+static pval *serial_close(deserial_frame_t *frame, const char **failure) {
+    pval *list = frame->list;
+    if (frame->tag == SERIAL_LIST) {
+        return list;
+    }
+    // A thunk is a lambda without parameters, and a body a list of forms.
+    pval *first = list->list_items[0];
+    if (frame->tag == SERIAL_PROMISE ? !frame->forced
+            && (first->type != PVAL_CLOSURE || first->code->param_count != 0)
+        : first->type != PVAL_LIST) {
+        pval_delete(list);
+        if (frame->code != NULL) {
+            lambda_code_release(frame->code);
+            frame->code = NULL;
+        }
+        *failure = "Malformed serialized data";
+        return NULL;
+    }
+    pval *closed = NULL;
+    if (frame->tag == SERIAL_PROMISE) {
+        pval *item = list->list_items[0];
+        promise_t *promise = frame->forced ? promise_new(NULL, item) : promise_new(item, NULL);
+        closed = promise == NULL ? NULL : pval_promise(promise);
+        if (closed == NULL) {
+            free(promise);
+            pval_delete(item);
+        }
+        free(list->list_items);
+    } else {
+        // The body comes first; the captures move down into its place and
+        // the item array becomes the capture vector.
+        lambda_code_t *code = frame->code;
+        frame->code = NULL;
+        code->body = list->list_items[0];
+        memmove(list->list_items, list->list_items + 1, code->capture_count * sizeof(pval *));
+        closed = pval_closure(code, list->list_items);
+        if (closed == NULL) {
+            for (int32_t i = 0; i < code->capture_count; i++) {
+                pval_delete(list->list_items[i]);
+            }
+            free(list->list_items);
+            lambda_code_release(code);
+        } else if (frame->memo_capacity >= 0) {
+            closed->memo = memo_table_new((int32_t)frame->memo_capacity);
+            if (closed->memo == NULL) {
+                pval_delete(closed);
+                closed = NULL;
+            }
+        }
+    }
+    free(list);
+    if (closed == NULL) {
+        *failure = "Out of memory";
+    }
+    return closed;
+}
+
+// Decodes the value encoded in length bytes from data, code included when
+// with_code is set.
+static pval *deserialize_value(const uint8_t *data, size_t length, bool with_code) {
+    if (length < sizeof(serial_magic) + 1
+        || memcmp(data, serial_magic, sizeof(serial_magic)) != 0) {
+        return pval_error("FormatError", "Not serialized data");
+    }
+    if (data[sizeof(serial_magic)] != SERIAL_VERSION) {
+        return pval_error("FormatError", "Unsupported serialization version");
+    }
+    serial_reader_t reader = {
+        .next = data + sizeof(serial_magic) + 1,
+        .end = data + length,
+        .with_code = with_code
+    };
+
+    pval *decoded_value = NULL;
+    const char *failure = NULL;
+    work_stack_t open_nodes;
+    work_stack_init(&open_nodes, sizeof(deserial_frame_t));
+    while (failure == NULL) {
+        deserial_frame_t opened;
+        pval *item = serial_get_value(&reader, &opened, &failure);
+        if (item == NULL) {
+            failure = failure != NULL ? failure : "Out of memory";
+            break;
+        }
+        if (opened.remaining > 0) {
+            deserial_frame_t *frame = work_stack_push(&open_nodes);
+            if (frame == NULL) {
+                pval_delete(opened.list);
+                if (opened.code != NULL) {
+                    lambda_code_release(opened.code);
+                }
+                failure = "Out of memory";
+                break;
+            }
+            *frame = opened;
+            continue;
+        }
+
+        // Close every node this item completes, innermost first.
+        while (item != NULL) {
+            item = pval_hash_cons(item);
+            if (open_nodes.count == 0) {
+                decoded_value = item;
+                break;
+            }
+            deserial_frame_t *frame = work_stack_top(&open_nodes);
+            frame->list->list_items[frame->list->list_count++] = item;
+            if (--frame->remaining > 0) {
+                break;
+            }
+            item = serial_close(frame, &failure);
+            open_nodes.count--;
+        }
+        if (decoded_value != NULL) {
+            break;
+        }
+    }
+    for (int32_t i = 0; i < open_nodes.count; i++) {
+        deserial_frame_t *frame = &((deserial_frame_t *)open_nodes.items)[i];
+        pval_delete(frame->list);
+        if (frame->code != NULL) {
+            lambda_code_release(frame->code);
+        }
+    }
+    work_stack_free(&open_nodes);
+    free(reader.symbols);
+
+    if (decoded_value != NULL && reader.next != reader.end) {
+        pval_delete(decoded_value);
+        return pval_error("FormatError", "Trailing bytes after serialized value");
+    }
+    if (decoded_value == NULL) {
+        return pval_error(strcmp(failure, "Out of memory") == 0 ? "MemoryError" : "FormatError",
+                          failure);
+    }
+    return decoded_value;
+}
+
+// (serialize v) returns the encoding of the data v as bytes.
+pval *builtin_serialize(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "serialize takes exactly 1 argument");
+    }
+    return serialize_value(args[0]);
+}
+
+// (deserialize b) returns the value the bytes b encode.
+pval *builtin_deserialize(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "deserialize takes exactly 1 argument");
+    }
+    if (args[0]->type != PVAL_BYTES) {
+        return pval_error("TypeError", "Argument to deserialize must be bytes");
+    }
+    return deserialize_value(args[0]->bytes->data, args[0]->bytes->length, false);
+}
+
+// (write-bytes path b) replaces the file named by the symbol path with the
+// bytes b and returns #t.
+pval *builtin_write_bytes(pval **args, int32_t arg_count) {
+    if (arg_count != 2) {
+        return pval_error("ArityError", "write-bytes takes exactly 2 arguments");
+    }
+    if (args[0]->type != PVAL_SYMBOL || args[1]->type != PVAL_BYTES) {
+        return pval_error("TypeError", "write-bytes takes a path symbol and bytes");
+    }
+    FILE *file = fopen(args[0]->symbol, "wb");
+    if (file == NULL) {
+        return pval_error("IOError", "Cannot open file for writing");
+    }
+    size_t written = fwrite(args[1]->bytes->data, 1, args[1]->bytes->length, file);
+    if (fclose(file) != 0 || written != args[1]->bytes->length) {
+        return pval_error("IOError", "Cannot write file");
+    }
+    return pval_bool(true);
+}
+
+// (read-bytes path) returns the contents of the file named by the symbol
+// path as bytes.
+pval *builtin_read_bytes(pval **args, int32_t arg_count) {
+    if (arg_count != 1) {
+        return pval_error("ArityError", "read-bytes takes exactly 1 argument");
+    }
+    if (args[0]->type != PVAL_SYMBOL) {
+        return pval_error("TypeError", "Argument to read-bytes must be a path symbol");
+    }
+    FILE *file = fopen(args[0]->symbol, "rb");
+    if (file == NULL) {
+        return pval_error("IOError", "Cannot open file for reading");
+    }
+    byte_string_t *bytes = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0 && (length = ftell(file)) >= 0
+        && fseek(file, 0, SEEK_SET) == 0) {
+        bytes = malloc(sizeof(byte_string_t) + (size_t)length);
+    }
+    if (bytes != NULL) {
+        *bytes = (byte_string_t){0, (size_t)length};
+        if (fread(bytes->data, 1, (size_t)length, file) != (size_t)length) {
+            free(bytes);
+            bytes = NULL;
+        }
+    }
+    fclose(file);
+    pval *contents = bytes == NULL ? NULL : pval_bytes(bytes);
+    if (contents == NULL) {
+        free(bytes);
+        return pval_error("IOError", "Cannot read file");
+    }
+    return contents;
+}
+
+// Macros
+// A macro call is expanded once: the transformer runs on the unevaluated
+// operands and the expansion is cached on the call site, so later
+// evaluations go straight to the expanded code. Expansion happens when the
+// site is first evaluated, when a lambda containing it is compiled, or when
+// --emit-c partially evaluates it, and transformers are expected to depend
+// only on their operands. Defining or redefining a macro advances
+// macro_generation, which retires every cached expansion; this is only
+// allowed at top level, where no expansion is being evaluated. Like special
+// forms, macro names take precedence over variables at the head of a call.
+
+// Returns the expansion of site, borrowed from its cache, or NULL when site
+// is not a macro call. If the transformer fails, nothing is cached and
+// *expand_error receives the error, owned by the caller.
+pval *macro_expansion(pval *form, pval **expand_error) {
+    *expand_error = NULL;
+    call_site_t *site = call_site_of(form);
+    if (site == NULL) {
+        *expand_error = pval_error("MemoryError", "Failed to expand macro");
+        return NULL;
+    }
+    if (site->expansion_generation == macro_generation) {
+        return site->expansion;
+    }
+    pval_delete(site->expansion);
+    site->expansion = NULL;
+    pval *transformer = NULL;
+    if (form->list_count > 0 && form->list_items[0]->type == PVAL_SYMBOL) {
+        transformer = global_lookup_macro(form->list_items[0]->symbol);
+    }
+    if (transformer != NULL) {
+        transformer = pval_copy(transformer);
+        pval *expansion = transformer == NULL ? NULL
+            : closure_call(transformer, form->list_items + 1, form->list_count - 1);
+        expansion = single_value(expansion);
+        pval_delete(transformer);
+        if (expansion == NULL || expansion->type == PVAL_ERROR) {
+            *expand_error = expansion != NULL ? expansion
+                : pval_error("MemoryError", "Failed to expand macro");
+            return NULL;
+        }
+        site->expansion = expansion;
+    }
+    site->expansion_generation = macro_generation;
+    return site->expansion;
+}
+
+// Partial Evaluation
+// Produces the residual of an expression: every call of a pure builtin whose
+// arguments are all constants is evaluated ahead of time and replaced by the
+// constant it yields, so only the calls that must happen at runtime remain.
+// The returned tree is owned by the caller.
+static bool builtin_is_pure(const char *name) {
+    for (int32_t i = 0; builtins[i].name != NULL; i++) {
+        if (strcmp(name, builtins[i].name) == 0) {
+            return builtins[i].pure;
+        }
+    }
+    return false;
+}
+
+static bool pval_is_constant(pval *input_value) {
+    return input_value->type == PVAL_NUMBER || input_value->type == PVAL_BOOL
+        || input_value->type == PVAL_ERROR
+        || (input_value->type == PVAL_LIST && input_value->list_count == 0);
+}
+
+static pval *pval_specialize(pval *input_value);
+
+// Copies a list, specializing the items from first_item on.
+static pval *specialize_items(pval *input_value, int32_t first_item) {
+    pval *residual = pval_list();
+    if (residual == NULL) {
+        return NULL;
+    }
+    for (int32_t i = 0; i < input_value->list_count; i++) {
+        pval_add(residual, i < first_item ? pval_copy(input_value->list_items[i])
+                                          : pval_specialize(input_value->list_items[i]));
+    }
+    return residual;
+}
+
+static bool items_are_constant(pval *input_value, int32_t first_item) {
+    for (int32_t i = first_item; i < input_value->list_count; i++) {
+        if (!pval_is_constant(input_value->list_items[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A special form is folded when all its operands are constants, and an if
+// with a constant test is replaced by the branch it takes.
+static pval *specialize_special_form(pval *input_value) {
+    const char *name = input_value->list_items[0]->symbol;
+    if (strcmp(name, "lambda") == 0 || strcmp(name, "defmemo") == 0
+        || strcmp(name, "defmacro") == 0 || strcmp(name, "quote") == 0
+        || strcmp(name, "delay") == 0 || strcmp(name, "receive") == 0) {
+        return pval_copy(input_value);
+    }
+
+    bool all_constant = true;
+    pval *residual;
+    if (strcmp(name, "cond") == 0) {
+        residual = pval_copy(input_value);
+        for (int32_t i = 1; residual != NULL && i < residual->list_count; i++) {
+            pval *clause = residual->list_items[i];
+            if (clause->type == PVAL_LIST) {
+                residual->list_items[i] = specialize_items(clause, 0);
+                pval_delete(clause);
+                clause = residual->list_items[i];
+            }
+            all_constant = all_constant && clause != NULL
+                && clause->type == PVAL_LIST && items_are_constant(clause, 0);
+        }
+    } else {
+        residual = specialize_items(input_value, 1);
+        all_constant = residual != NULL && items_are_constant(residual, 1);
+    }
+    if (residual == NULL) {
+        return pval_error("MemoryError", "Failed to allocate list");
+    }
+
+    pval *folded = NULL;
+    if (all_constant) {
+        folded = pval_eval(residual);
+    } else if (strcmp(name, "if") == 0 && (residual->list_count == 3 || residual->list_count == 4)
+               && pval_is_constant(residual->list_items[1])) {
+        pval *test = residual->list_items[1];
+        if (test->type == PVAL_ERROR) {
+            folded = pval_copy(test);
+        } else if (pval_is_truthy(test)) {
+            folded = pval_copy(residual->list_items[2]);
+        } else {
+            folded = residual->list_count == 4 ? pval_copy(residual->list_items[3]) : pval_list();
+        }
+    }
+    if (folded == NULL) {
+        return residual;
+    }
+    pval_delete(residual);
+    return folded;
+}
+
+// Macro calls are replaced by their specialized expansion. Expressions nested
+// past the depth limit are left as they are. A fold that yields a value with
+// no literal form, such as a non-empty list, is not applied.
+pval *pval_specialize(pval *input_value) {
+    if (input_value->type != PVAL_LIST || !nesting_enter()) {
+        return pval_copy(input_value);
+    }
+    pval *expand_error;
+    pval *expansion = macro_expansion(input_value, &expand_error);
+    if (expand_error != NULL || expansion != NULL) {
+        pval *residual = expand_error != NULL ? expand_error : pval_specialize(expansion);
+        nesting_leave();
+        return residual;
+    }
+    if (is_special_form(input_value)) {
+        pval *residual = specialize_special_form(input_value);
+        nesting_leave();
+        return residual;
+    }
+    pval *residual = specialize_items(input_value, 0);
+    nesting_leave();
+    if (residual == NULL) {
+        return pval_error("MemoryError", "Failed to allocate list");
+    }
+    bool foldable = residual->list_count > 0
+        && residual->list_items[0]->type == PVAL_SYMBOL
+        && builtin_is_pure(residual->list_items[0]->symbol)
+        && items_are_constant(residual, 1);
+    if (!foldable) {
+        return residual;
+    }
+    pval *folded = pval_eval(residual);
+    if (folded != NULL && !pval_is_constant(folded)) {
+        pval_delete(folded);
+        return residual;
+    }
+    pval_delete(residual);
+    return folded;
+}
+
+// Numeric Trace
+// Arithmetic trees are first run through a trace specialised on numbers: the
+// whole expression folds into one double without allocating intermediate
+// pvals. Each node carries a guard. A failed type guard (a variable that is
+// not bound to a number, a zero divisor) exits to the generic evaluator for
+// this evaluation only; a shape the trace does not cover at all (a
+// non-arithmetic head, an arity mismatch) also marks the node so it is never
+// retried. Either way the generic evaluator then produces the normal value or
+// error.
+typedef enum {
+    TRACE_OK,
+    TRACE_GUARD_FAILED,
+    TRACE_EXIT
+} trace_status_t;
+
+static bool trace_marked(pval *input_value) {
+    return input_value->type == PVAL_LIST && input_value->site != NULL
+        && input_value->site->trace_failed;
+}
+
+// Leaves are cheap to recheck, so only calls are marked.
+static trace_status_t trace_exit(pval *input_value) {
+    if (input_value->type == PVAL_LIST && call_site_of(input_value) != NULL) {
+        input_value->site->trace_failed = true;
+    }
+    return TRACE_EXIT;
+}
+
+// Reads a number literal or a number-bound variable.
+static trace_status_t trace_leaf(pval *input_value, double *result) {
+    if (input_value->type == PVAL_NUMBER) {
+        *result = input_value->number;
+        return TRACE_OK;
+    }
+    if (input_value->type == PVAL_SYMBOL) {
+        pval *bound_value = frame_lookup_symbol(input_value);
+        if (bound_value == NULL) {
+            bound_value = global_lookup(input_value->symbol);
+        }
+        if (bound_value == NULL || bound_value->type != PVAL_NUMBER) {
+            return TRACE_GUARD_FAILED;
+        }
+        *result = bound_value->number;
+        return TRACE_OK;
+    }
+    return trace_exit(input_value);
+}
+
+// An arithmetic call whose operands are still being folded.
+typedef struct trace_frame {
+    pval *call;
+    builtin_function_ptr head;
+    int32_t next_arg;
+    double running;
+} trace_frame_t;
+
+static trace_status_t trace_open(pval *input_value, trace_frame_t *frame) {
+    if (trace_marked(input_value)) {
+        return TRACE_EXIT;
+    }
+    if (input_value->list_count == 0 || input_value->list_items[0]->type != PVAL_SYMBOL) {
+        return trace_exit(input_value);
+    }
+
+    builtin_function_ptr head;
+    pval *bound_head = frame_lookup_symbol(input_value->list_items[0]);
+    if (bound_head != NULL) {
+        if (bound_head->type != PVAL_FUNCTION) {
+            return TRACE_GUARD_FAILED;
+        }
+        head = bound_head->function;
+    } else {
+        head = lookup_builtin(input_value->list_items[0]->symbol);
+    }
+    int32_t num_args = input_value->list_count - 1;
+    if (head != builtin_add && head != builtin_mul
+        && !(head == builtin_sub && (num_args == 1 || num_args == 2))
+        && !(head == builtin_div && num_args == 2)) {
+        return trace_exit(input_value);
+    }
+    *frame = (trace_frame_t){input_value, head, 0, head == builtin_mul ? 1.0 : 0.0};
+    return TRACE_OK;
+}
+
+static trace_status_t trace_combine(trace_frame_t *frame, double operand) {
+    int32_t arg_index = frame->next_arg++;
+    if (frame->head == builtin_add) {
+        frame->running += operand;
+    } else if (frame->head == builtin_mul) {
+        frame->running *= operand;
+    } else if (arg_index == 0) {
+        frame->running = operand;
+    } else if (frame->head == builtin_sub) {
+        frame->running -= operand;
+    } else if (operand == 0.0) {
+        return TRACE_GUARD_FAILED;
+    } else {
+        frame->running /= operand;
+    }
+    return TRACE_OK;
+}
+
+static double trace_close(trace_frame_t *frame) {
+    if (frame->head == builtin_sub && frame->call->list_count == 2) {
+        return -frame->running;
+    }
+    return frame->running;
+}
+
+// Folds the tree with an explicit stack of open calls, so any nesting depth
+// is traced in linear time. When a shape is not covered, every call still
+// open is marked along with the node that failed.
+static trace_status_t pval_eval_numeric(pval *input_value, double *result) {
+    if (trace_marked(input_value)) {
+        return TRACE_EXIT;
+    }
+    if (input_value->type != PVAL_LIST) {
+        return trace_leaf(input_value, result);
+    }
+
+    work_stack_t open_calls;
+    work_stack_init(&open_calls, sizeof(trace_frame_t));
+    trace_frame_t *frame = work_stack_push(&open_calls);
+    trace_status_t status = trace_open(input_value, frame);
+    if (status != TRACE_OK) {
+        open_calls.count--;
+    }
+    while (status == TRACE_OK && open_calls.count > 0) {
+        frame = work_stack_top(&open_calls);
+        if (frame->next_arg < frame->call->list_count - 1) {
+            pval *arg = frame->call->list_items[frame->next_arg + 1];
+            if (arg->type == PVAL_LIST) {
+                trace_frame_t *child = work_stack_push(&open_calls);
+                if (child == NULL) {
+                    status = TRACE_GUARD_FAILED;
+                } else if ((status = trace_open(arg, child)) != TRACE_OK) {
+                    open_calls.count--;
+                }
+                continue;
+            }
+            double operand;
+            if ((status = trace_leaf(arg, &operand)) == TRACE_OK) {
+                status = trace_combine(frame, operand);
+            }
+            continue;
+        }
+        double value = trace_close(frame);
+        open_calls.count--;
+        if (open_calls.count == 0) {
+            *result = value;
+        } else {
+            status = trace_combine(work_stack_top(&open_calls), value);
+        }
+    }
+    if (status == TRACE_EXIT) {
+        for (int32_t i = 0; i < open_calls.count; i++) {
+            trace_exit(((trace_frame_t *)open_calls.items)[i].call);
+        }
+    }
+    work_stack_free(&open_calls);
+    return status;
+}
+
+// Profiler
+// --profile counts, for every call site evaluated, each pair of consecutive
+// items in evaluation order by the kind of step they take, and reports the
+// pairs by frequency on exit. These are the sequences the superinstructions
+// below are chosen from.
+static bool profile_enabled = false;
+
+typedef enum {
+    PROFILE_LITERAL,
+    PROFILE_VARIABLE,
+    PROFILE_BUILTIN,
+    PROFILE_LAMBDA,
+    PROFILE_SPECIAL,
+    PROFILE_CALL,
+    PROFILE_OP_COUNT
+} profile_op_t;
+
+static const char *profile_op_names[PROFILE_OP_COUNT] = {
+    "literal", "load-variable", "load-builtin", "lambda", "special-form", "call"
+};
+
+static uint64_t profile_pairs[PROFILE_OP_COUNT][PROFILE_OP_COUNT];
+static uint64_t profile_direct_sites;
+static uint64_t profile_traces;
+
+static void profile_count_trace(void) {
+    if (profile_enabled) {
+        profile_traces++;
+    }
+}
+
+static profile_op_t profile_op_of(pval *item) {
+    switch (item->type) {
+    case PVAL_SYMBOL:
+        return frame_lookup_symbol(item) != NULL ? PROFILE_VARIABLE : PROFILE_BUILTIN;
+    case PVAL_LIST:
+        if (item->list_count == 0) {
+            return PROFILE_LITERAL;
+        }
+        if (is_lambda_form(item)) {
+            return PROFILE_LAMBDA;
+        }
+        return is_special_form(item) ? PROFILE_SPECIAL : PROFILE_CALL;
+    default:
+        return PROFILE_LITERAL;
+    }
+}
+
+static void profile_site(pval *input_value) {
+    for (int32_t i = 1; i < input_value->list_count; i++) {
+        profile_pairs[profile_op_of(input_value->list_items[i - 1])]
+                     [profile_op_of(input_value->list_items[i])]++;
+    }
+}
+
+static MAIN_ONLY void profile_report(FILE *out) {
+    uint64_t *counts[PROFILE_OP_COUNT * PROFILE_OP_COUNT];
+    int32_t pair_count = 0;
+    for (int32_t i = 0; i < PROFILE_OP_COUNT; i++) {
+        for (int32_t j = 0; j < PROFILE_OP_COUNT; j++) {
+            if (profile_pairs[i][j] > 0) {
+                counts[pair_count++] = &profile_pairs[i][j];
+            }
+        }
+    }
+    for (int32_t i = 1; i < pair_count; i++) {
+        for (int32_t j = i; j > 0 && *counts[j] > *counts[j - 1]; j--) {
+            uint64_t *swap = counts[j];
+            counts[j] = counts[j - 1];
+            counts[j - 1] = swap;
+        }
+    }
+    fprintf(out, "profile: %llu numeric traces, %llu fused builtin calls\n",
+            (unsigned long long)profile_traces, (unsigned long long)profile_direct_sites);
+    for (int32_t i = 0; i < pair_count; i++) {
+        int32_t pair = (int32_t)(counts[i] - &profile_pairs[0][0]);
+        fprintf(out, "profile: %12llu  %s -> %s\n", (unsigned long long)*counts[i],
+                profile_op_names[pair / PROFILE_OP_COUNT],
+                profile_op_names[pair % PROFILE_OP_COUNT]);
+    }
+}
+
+// Escape Analysis
+// The items of an application never escape the call: builtins build fresh
+// results, and a closure body only reaches its arguments through variable
+// lookups, which copy. So the temporaries can live in the caller's frame
+// instead of the heap. Literals are passed as the expression nodes themselves,
+// variables as the values already held by the current frame or lent by their
+// global binding, and builtin heads and numeric trace results as pval slots
+// on the C stack. Only the remaining items are evaluated onto the heap, and
+// only those are deleted.
+#define INLINE_CALL_ITEMS 4
+
+typedef struct call_temp {
+    pval slot;
+    bool owned;
+    bool lent; // A global's value; see global_retire
+} call_temp_t;
+
+static pval *eval_application(pval *input_value);
+
+static pval *eval_temporary(pval *item, call_temp_t *temp) {
+    temp->owned = false;
+    temp->lent = false;
+    switch (item->type) {
+    case PVAL_NUMBER:
+    case PVAL_BOOL:
+    case PVAL_ERROR:
+        return item;
+    case PVAL_SYMBOL: {
+        pval *bound_value = frame_lookup_symbol(item);
+        if (bound_value != NULL) {
+            return bound_value;
+        }
+        bound_value = global_lookup(item->symbol);
+        if (bound_value != NULL) {
+            // The call could rebind the global, so its value stays alive
+            // until the loan ends.
+            temp->lent = true;
+            global_loans++;
+            return bound_value;
+        }
+        builtin_function_ptr bound_function = lookup_builtin(item->symbol);
+        if (bound_function != NULL) {
+            temp->slot = (pval){.type = PVAL_FUNCTION, .function = bound_function};
+            return &temp->slot;
+        }
+        break;
+    }
+    case PVAL_LIST: {
+        double numeric_result;
+        if (item->list_count == 0 || is_special_form(item)) {
+            break;
+        }
+        pval *expand_error;
+        pval *expansion = macro_expansion(item, &expand_error);
+        if (expand_error != NULL) {
+            temp->owned = true;
+            return expand_error;
+        }
+        if (expansion != NULL) {
+            // The expansion stands in for the call, literals and traces included.
+            if (!nesting_enter()) {
+                temp->owned = true;
+                return nesting_error();
+            }
+            pval *eval_result = eval_temporary(expansion, temp);
+            nesting_leave();
+            return eval_result;
+        }
+        if (pval_eval_numeric(item, &numeric_result) == TRACE_OK) {
+            profile_count_trace();
+            temp->slot = (pval){.type = PVAL_NUMBER, .number = numeric_result};
+            return &temp->slot;
+        }
+        temp->owned = true;
+        if (!nesting_enter()) {
+            return nesting_error();
+        }
+        pval *eval_result = eval_application(item);
+        nesting_leave();
+        return eval_result;
+    }
+    default:
+        break;
+    }
+    temp->owned = true;
+    return pval_eval(item);
+}
+
+// Frees item if temp owns it, and ends the loan of a global's value.
+static void call_temp_release(call_temp_t *temp, pval *item) {
+    if (temp->owned) {
+        pval_delete(item);
+    }
+    if (temp->lent) {
+        global_loan_end();
+    }
+}
+
+// Superinstructions
+// Call sites are classified the first time they run, into the shapes that
+// dominate --profile output: a builtin called with literals and variables
+// only (which covers a builtin over two literal numbers and a variable load
+// feeding an arithmetic builtin) runs as one fused step that resolves the
+// head once, then reads its arguments straight from the expression and the
+// frame without the per-item evaluate-and-check loop. Other sites take the
+// generic path.
+typedef enum {
+    SITE_UNKNOWN,
+    SITE_GENERIC,
+    SITE_DIRECT_BUILTIN
+} site_kind_t;
+
+static void classify_site(pval *input_value, call_site_t *site) {
+    site->site_kind = SITE_GENERIC;
+    pval *head = input_value->list_items[0];
+    if (head->type != PVAL_SYMBOL || frame_lookup_symbol(head) != NULL) {
+        return;
+    }
+    builtin_function_ptr site_builtin = lookup_builtin(head->symbol);
+    if (site_builtin == NULL) {
+        return;
+    }
+    for (int32_t i = 1; i < input_value->list_count; i++) {
+        pval *item = input_value->list_items[i];
+        if (item->type != PVAL_NUMBER && item->type != PVAL_BOOL
+            && (item->type != PVAL_SYMBOL || frame_lookup_symbol(item) == NULL)) {
+            return;
+        }
+    }
+    site->site_builtin = site_builtin;
+    site->site_kind = SITE_DIRECT_BUILTIN;
+}
+
+static pval *eval_direct_builtin(pval *input_value) {
+    int32_t num_args = input_value->list_count - 1;
+    pval *inline_args[INLINE_CALL_ITEMS];
+    pval **args = inline_args;
+    if (num_args > INLINE_CALL_ITEMS) {
+        args = malloc(num_args * sizeof(pval *));
+        if (args == NULL) {
+            return pval_error("MemoryError", "Failed to allocate arguments for function call");
+        }
+    }
+    for (int32_t i = 0; i < num_args; i++) {
+        pval *item = input_value->list_items[i + 1];
+        args[i] = item->type == PVAL_SYMBOL ? frame_lookup_symbol(item) : item;
+    }
+    pval *eval_result = input_value->site->site_builtin(args, num_args);
+    if (args != inline_args) {
+        free(args);
+    }
+    return eval_result;
+}
+
+static pval *eval_application(pval *input_value) {
+    if (profile_enabled) {
+        profile_site(input_value);
+    }
+    call_site_t *site = call_site_of(input_value);
+    if (site != NULL && site->site_kind == SITE_UNKNOWN) {
+        classify_site(input_value, site);
+    }
+    if (site != NULL && site->site_kind == SITE_DIRECT_BUILTIN) {
+        if (profile_enabled) {
+            profile_direct_sites++;
+        }
+        return eval_direct_builtin(input_value);
+    }
+
+    int32_t item_count = input_value->list_count;
+    pval *inline_items[INLINE_CALL_ITEMS];
+    call_temp_t inline_temps[INLINE_CALL_ITEMS];
+    pval **evaluated_items = inline_items;
+    call_temp_t *temps = inline_temps;
+    if (item_count > INLINE_CALL_ITEMS) {
+        evaluated_items = malloc(item_count * sizeof(pval *));
+        temps = malloc(item_count * sizeof(call_temp_t));
+        if (evaluated_items == NULL || temps == NULL) {
+            free(evaluated_items);
+            free(temps);
+            return pval_error("MemoryError", "Failed to allocate evaluated items");
+        }
+    }
+
+    pval *eval_result = NULL;
+    int32_t evaluated_count = 0;
+    while (evaluated_count < item_count) {
+        pval *item = eval_temporary(input_value->list_items[evaluated_count],
+                                    &temps[evaluated_count]);
+        evaluated_items[evaluated_count++] = item;
+        if (item == NULL) {
+            eval_result = pval_error("EvalError", "Null evaluation result");
+            break;
+        }
+        if (item->type == PVAL_ERROR) {
+            eval_result = pval_error(item->error_type, item->error_message);
+            break;
+        }
+    }
+    if (eval_result == NULL) {
+        eval_result = apply_items(evaluated_items, item_count);
+    }
+
+    for (int32_t i = 0; i < evaluated_count; i++) {
+        call_temp_release(&temps[i], evaluated_items[i]);
+    }
+    if (evaluated_items != inline_items) {
+        free(evaluated_items);
+        free(temps);
+    }
+    return eval_result;
+}
+
+// Special Forms
+// Forms whose operands are not all evaluated. They are dispatched on the head
+// symbol before any argument is evaluated, so branches that are not taken are
+// never evaluated or allocated. A missing alternative, or a cond without a
+// matching clause, yields ().
+typedef pval *(*special_form_ptr)(pval *input_value);
+
+typedef struct special_form {
+    const char *name;
+    special_form_ptr eval;
+} special_form_t;
+
+static pval *special_if(pval *input_value);
+static pval *special_cond(pval *input_value);
+static pval *special_and(pval *input_value);
+static pval *special_or(pval *input_value);
+static pval *special_define(pval *input_value);
+static pval *special_defmemo(pval *input_value);
+static pval *special_defmacro(pval *input_value);
+static pval *special_quote(pval *input_value);
+static pval *special_delay(pval *input_value);
+static pval *special_receive(pval *input_value);
+
+special_form_t special_forms[] = {
+    {"lambda", eval_lambda},
+    {"if", special_if},
+    {"cond", special_cond},
+    {"and", special_and},
+    {"or", special_or},
+    {"define", special_define},
+    {"defmemo", special_defmemo},
+    {"defmacro", special_defmacro},
+    {"quote", special_quote},
+    {"delay", special_delay},
+    {"receive", special_receive},
+    {NULL, NULL}
+};
+
+static special_form_ptr lookup_special_form(pval *input_value) {
+    if (input_value->type != PVAL_LIST || input_value->list_count == 0
+        || input_value->list_items[0]->type != PVAL_SYMBOL) {
+        return NULL;
+    }
+    for (int32_t i = 0; special_forms[i].name != NULL; i++) {
+        if (strcmp(input_value->list_items[0]->symbol, special_forms[i].name) == 0) {
+            return special_forms[i].eval;
+        }
+    }
+    return NULL;
+}
+
+bool is_special_form(pval *input_value) {
+    return lookup_special_form(input_value) != NULL;
+}
+
+// Compare-then-branch: a test of the form (= a b) over numbers is decided from
+// the numeric trace without allocating the boolean.
+static trace_status_t trace_condition(pval *test, bool *truthy) {
+    if (test->type != PVAL_LIST || test->list_count != 3
+        || test->list_items[0]->type != PVAL_SYMBOL) {
+        return TRACE_EXIT;
+    }
+    pval *bound_head = frame_lookup_symbol(test->list_items[0]);
+    builtin_function_ptr head = bound_head == NULL ? lookup_builtin(test->list_items[0]->symbol)
+        : bound_head->type == PVAL_FUNCTION ? bound_head->function : NULL;
+    if (head != builtin_eq) {
+        return TRACE_EXIT;
+    }
+    double first, second;
+    trace_status_t status = pval_eval_numeric(test->list_items[1], &first);
+    if (status == TRACE_OK) {
+        status = pval_eval_numeric(test->list_items[2], &second);
+    }
+    if (status == TRACE_OK) {
+        *truthy = fabs(first - second) < NUMBER_EQUAL_EPSILON;
+    }
+    return status;
+}
+
+// Decides a condition without keeping its value. Returns NULL once *truthy is
+// set, or the error the condition evaluated to.
+static pval *eval_condition(pval *test, bool *truthy) {
+    if (trace_condition(test, truthy) == TRACE_OK) {
+        return NULL;
+    }
+    call_temp_t temp;
+    pval *test_value = eval_temporary(test, &temp);
+    if (test_value == NULL) {
+        return pval_error("EvalError", "Null evaluation result");
+    }
+    if (temp.owned) {
+        test_value = single_value(test_value);
+    }
+    if (test_value->type == PVAL_ERROR) {
+        pval *error = temp.owned ? test_value : pval_copy(test_value);
+        temp.owned = false;
+        call_temp_release(&temp, error);
+        return error;
+    }
+    *truthy = pval_is_truthy(test_value);
+    call_temp_release(&temp, test_value);
+    return NULL;
+}
+
+pval *special_if(pval *input_value) {
+    if (input_value->list_count != 3 && input_value->list_count != 4) {
+        return pval_error("SyntaxError", "if requires a test, a consequent and an optional alternative");
+    }
+    bool truthy;
+    pval *test_error = eval_condition(input_value->list_items[1], &truthy);
+    if (test_error != NULL) {
+        return test_error;
+    }
+    if (truthy) {
+        return pval_eval(input_value->list_items[2]);
+    }
+    return input_value->list_count == 4 ? pval_eval(input_value->list_items[3]) : pval_list();
+}
+
+pval *special_cond(pval *input_value) {
+    for (int32_t i = 1; i < input_value->list_count; i++) {
+        pval *clause = input_value->list_items[i];
+        if (clause->type != PVAL_LIST || clause->list_count == 0) {
+            return pval_error("SyntaxError", "cond clauses must be non-empty lists");
+        }
+    }
+    for (int32_t i = 1; i < input_value->list_count; i++) {
+        pval *clause = input_value->list_items[i];
+        pval *test = clause->list_items[0];
+        bool is_else = test->type == PVAL_SYMBOL && strcmp(test->symbol, "else") == 0;
+        if (clause->list_count == 1 && !is_else) {
+            // A clause without a body yields the test's own value.
+            pval *test_value = pval_eval(test);
+            if (test_value == NULL || test_value->type == PVAL_ERROR
+                || pval_is_truthy(test_value)) {
+                return test_value;
+            }
+            pval_delete(test_value);
+            continue;
+        }
+        bool truthy = is_else;
+        if (!is_else) {
+            pval *test_error = eval_condition(test, &truthy);
+            if (test_error != NULL) {
+                return test_error;
+            }
+        }
+        if (!truthy) {
+            continue;
+        }
+        pval *eval_result = NULL;
+        for (int32_t k = 1; k < clause->list_count; k++) {
+            pval_delete(eval_result);
+            eval_result = pval_eval(clause->list_items[k]);
+            if (eval_result == NULL || eval_result->type == PVAL_ERROR) {
+                break;
+            }
+        }
+        return eval_result != NULL ? eval_result : pval_list();
+    }
+    return pval_list();
+}
+
+pval *special_and(pval *input_value) {
+    if (input_value->list_count == 1) {
+        return pval_bool(true);
+    }
+    for (int32_t i = 1; i < input_value->list_count - 1; i++) {
+        bool truthy;
+        pval *test_error = eval_condition(input_value->list_items[i], &truthy);
+        if (test_error != NULL) {
+            return test_error;
+        }
+        if (!truthy) {
+            return pval_bool(false);
+        }
+    }
+    return pval_eval(input_value->list_items[input_value->list_count - 1]);
+}
+
+pval *special_or(pval *input_value) {
+    for (int32_t i = 1; i < input_value->list_count - 1; i++) {
+        call_temp_t temp;
+        pval *item = eval_temporary(input_value->list_items[i], &temp);
+        if (temp.owned) {
+            item = single_value(item);
+        }
+        if (item == NULL || item->type == PVAL_ERROR || pval_is_truthy(item)) {
+            pval *result = temp.owned || item == NULL ? item : pval_copy(item);
+            temp.owned = false;
+            call_temp_release(&temp, result);
+            return result;
+        }
+        call_temp_release(&temp, item);
+    }
+    if (input_value->list_count == 1) {
+        return pval_bool(false);
+    }
+    return pval_eval(input_value->list_items[input_value->list_count - 1]);
+}
+
+// Returns the error for a name that cannot be defined, or NULL. Macro
+// bindings only change at top level, so no cached expansion is retired
+// while it is being evaluated.
+static pval *check_definable(pval *name, bool macro) {
+    if (name->type != PVAL_SYMBOL) {
+        return pval_error("SyntaxError", "Only symbols can be defined");
+    }
+    if (lookup_builtin(name->symbol) != NULL) {
+        return pval_error("DefineError", "Builtins cannot be redefined");
+    }
+    for (int32_t i = 0; special_forms[i].name != NULL; i++) {
+        if (strcmp(name->symbol, special_forms[i].name) == 0) {
+            return pval_error("DefineError", "Special forms cannot be redefined");
+        }
+    }
+    if ((macro || global_lookup_macro(name->symbol) != NULL) && nesting_depth > 1) {
+        return pval_error("DefineError", "Macros can only be defined at top level");
+    }
+    return NULL;
+}
+
+// (define name expr) binds name globally and yields name.
+pval *special_define(pval *input_value) {
+    if (input_value->list_count != 3) {
+        return pval_error("SyntaxError", "define requires a name and a value");
+    }
+    pval *name = input_value->list_items[1];
+    pval *name_error = check_definable(name, false);
+    if (name_error != NULL) {
+        return name_error;
+    }
+    pval *value = single_value(pval_eval(input_value->list_items[2]));
+    if (value == NULL || value->type == PVAL_ERROR) {
+        return value;
+    }
+    if (!global_define(name->symbol, value, false)) {
+        pval_delete(value);
+        return pval_error("MemoryError", "Failed to bind global");
+    }
+    return pval_symbol(name->symbol);
+}
+
+// Evaluates (form name (params) body...) into the closure of
+// (lambda (params) body...), checking that name can be bound.
+static pval *eval_named_lambda(pval *input_value, bool macro) {
+    if (input_value->list_count < 4) {
+        return pval_error("SyntaxError", "Definition requires a name, a parameter list and a body");
+    }
+    pval *name_error = check_definable(input_value->list_items[1], macro);
+    if (name_error != NULL) {
+        return name_error;
+    }
+    pval *lambda_expr = pval_list();
+    if (lambda_expr == NULL) {
+        return pval_error("MemoryError", "Failed to allocate list");
+    }
+    pval_add(lambda_expr, pval_symbol("lambda"));
+    for (int32_t i = 2; i < input_value->list_count; i++) {
+        pval_add(lambda_expr, pval_copy(input_value->list_items[i]));
+    }
+    pval *closure = eval_lambda(lambda_expr);
+    pval_delete(lambda_expr);
+    return closure;
+}
+
+// (defmemo name (params) body...) is define of a memoized lambda, so the
+// body's recursive calls through name go through the memo table too.
+pval *special_defmemo(pval *input_value) {
+    pval *closure = eval_named_lambda(input_value, false);
+    if (closure == NULL || closure->type == PVAL_ERROR) {
+        return closure;
+    }
+    const char *name = input_value->list_items[1]->symbol;
+    closure->memo = memo_table_new(0);
+    if (closure->memo == NULL || !global_define(name, closure, false)) {
+        pval_delete(closure);
+        return pval_error("MemoryError", "Failed to bind global");
+    }
+    return pval_symbol(name);
+}
+
+// (defmacro name (params) body...) binds a transformer: the body receives the
+// operands of a call unevaluated and returns the code to run in its place.
+pval *special_defmacro(pval *input_value) {
+    pval *closure = eval_named_lambda(input_value, true);
+    if (closure == NULL || closure->type == PVAL_ERROR) {
+        return closure;
+    }
+    const char *name = input_value->list_items[1]->symbol;
+    if (!global_define(name, closure, true)) {
+        pval_delete(closure);
+        return pval_error("MemoryError", "Failed to bind global");
+    }
+    return pval_symbol(name);
+}
+
+// (quote datum) yields datum itself, unevaluated.
+pval *special_quote(pval *input_value) {
+    if (input_value->list_count != 2) {
+        return pval_error("SyntaxError", "quote requires exactly one datum");
+    }
+    return pval_copy(input_value->list_items[1]);
+}
+
+// (delay expr) makes a promise of expr's value. expr is compiled like the
+// body of a lambda without parameters and captures its free variables, so a
+// promise needs no environment to be forced later.
+pval *special_delay(pval *input_value) {
+    if (input_value->list_count != 2) {
+        return pval_error("SyntaxError", "delay requires exactly one expression");
+    }
+    if (code_is_stale(input_value)) {
+        pval *compile_error = compile_code(input_value, NULL, 1);
+        if (compile_error != NULL) {
+            return compile_error;
+        }
+    }
+    pval *thunk = make_closure(input_value);
+    if (thunk->type == PVAL_ERROR) {
+        return thunk;
+    }
+    promise_t *promise = promise_new(thunk, NULL);
+    if (promise == NULL) {
+        pval_delete(thunk);
+    }
+    return wrap_promise(promise);
+}
+
+// (receive (formals) expr body...) evaluates expr and runs body with the
+// formals bound to its values. body is compiled like the body of a lambda,
+// but it runs at once in a frame on the C stack that borrows the captured
+// variables from the enclosing frame, so neither the values nor a closure
+// are allocated.
+pval *special_receive(pval *input_value) {
+    if (input_value->list_count < 4 || input_value->list_items[1]->type != PVAL_LIST) {
+        return pval_error("SyntaxError", "receive requires formals, an expression and a body");
+    }
+    pval *formals = input_value->list_items[1];
+    for (int32_t i = 0; i < formals->list_count; i++) {
+        if (formals->list_items[i]->type != PVAL_SYMBOL) {
+            return pval_error("SyntaxError", "receive formals must be symbols");
+        }
+    }
+    if (code_is_stale(input_value)) {
+        pval *compile_error = compile_code(input_value, formals, 3);
+        if (compile_error != NULL) {
+            return compile_error;
+        }
+    }
+    pval *produced = pval_eval(input_value->list_items[2]);
+    if (produced == NULL || produced->type == PVAL_ERROR) {
+        return produced;
+    }
+    pval *values[MAX_VALUES];
+    int32_t count = values_take(produced, values);
+    lambda_code_t *code = input_value->site->code;
+    pval *eval_result = count == code->param_count
+        ? run_code(code, values, NULL)
+        : pval_error("ArityError", "Wrong number of values for receive");
+    for (int32_t i = 0; i < count; i++) {
+        pval_delete(values[i]);
+    }
+    return eval_result;
+}
+
+static pval *eval_expression(pval *input_value) {
+    if (input_value == NULL) {
+        return NULL;
+    }
+
+    if (input_value->type == PVAL_NUMBER || input_value->type == PVAL_BOOL
+        || input_value->type == PVAL_ERROR) {
+        if (input_value->type == PVAL_NUMBER) {
+            return pval_number(input_value->number);
+        }
+        if (input_value->type == PVAL_BOOL) {
+            return pval_bool(input_value->boolean);
+        }
+        return pval_error(input_value->error_type, input_value->error_message);
+    }
+
+    if (input_value->type == PVAL_SYMBOL) {
+        pval *bound_value = frame_lookup_symbol(input_value);
+        if (bound_value == NULL) {
+            bound_value = global_lookup(input_value->symbol);
+        }
+        if (bound_value != NULL) {
+            return pval_copy(bound_value);
+        }
+        builtin_function_ptr bound_function = lookup_builtin(input_value->symbol);
+        if (bound_function != NULL) {
+            return pval_function(bound_function);
+        }
+        return pval_error("UnboundError", "Symbol not bound to a function");
+    }
+
+    if (input_value->type == PVAL_LIST) {
+        if (input_value->list_count < 0) {
+            return pval_error("ListError", "Invalid list count");
+        }
+        
+        if (input_value->list_count == 0) {
+            return pval_list();
+        }
+
+        special_form_ptr special_form = lookup_special_form(input_value);
+        if (special_form != NULL) {
+            return special_form(input_value);
+        }
+
+        pval *expand_error;
+        pval *expansion = macro_expansion(input_value, &expand_error);
+        if (expand_error != NULL) {
+            return expand_error;
+        }
+        if (expansion != NULL) {
+            return pval_eval(expansion);
+        }
+
+        double numeric_result;
+        if (pval_eval_numeric(input_value, &numeric_result) == TRACE_OK) {
+            profile_count_trace();
+            return pval_number(numeric_result);
+        }
+        return eval_application(input_value);
+    }
+
+    return pval_error("EvalError", "Unsupported pval type for evaluation");
+}
+
+pval *pval_eval(pval *input_value) {
+    if (!nesting_enter()) {
+        return nesting_error();
+    }
+    pval *eval_result = eval_expression(input_value);
+    nesting_leave();
+    return eval_result;
+}
+
+// Value of the global variable name, as evaluating the symbol at top level
+// gives it. This and pval_condition are called by the code --emit-c
+// generates; see C Code Emitter.
+pval *pval_global(const char *name) {
+    char *interned = symbol_intern(name, strlen(name));
+    if (interned == NULL) {
+        return pval_error("MemoryError", "Failed to intern symbol");
+    }
+    pval *bound_value = global_lookup(interned);
+    return bound_value != NULL ? pval_copy(bound_value)
+        : pval_error("UnboundError", "Symbol not bound to a function");
+}
+
+// Decides the condition of an emitted if, cond or and. Consumes test_value;
+// returns NULL once *truthy is set, or the error the condition evaluated to.
+pval *pval_condition(pval *test_value, bool *truthy) {
+    if (test_value == NULL) {
+        return pval_error("EvalError", "Null evaluation result");
+    }
+    test_value = single_value(test_value);
+    if (test_value->type == PVAL_ERROR) {
+        return test_value;
+    }
+    *truthy = pval_is_truthy(test_value);
+    pval_delete(test_value);
+    return NULL;
+}
+
+// Prints a top-level result the way the REPL shows it. Returns false once the
+// result asks the interpreter to quit.
+static bool report_result(pval *final_result) {
+    if (final_result == NULL) {
+        printf("$error{EvalError Null result from evaluation}\n");
+        return true;
+    }
+    if (final_result->type == PVAL_SYMBOL &&
+        strcmp(final_result->symbol, "quitting") == 0) {
+        printf("Quitting...\n");
+        pval_delete(final_result);
+        return false;
+    }
+    pval_write(final_result);
+    output_text("\n");
+    output_flush();
+    pval_delete(final_result);
+    return true;
+}
+
+#ifndef PSI_NO_MAIN
+// Source Files
+// Program files are mapped read-only and parsed in place, without copying
+// them into a buffer first. The mapping extends past the file with anonymous
+// zeroed memory, so the text always ends in the '\0' the parser stops at,
+// followed by PARSE_PADDING bytes, even when the file fills its last page.
+typedef struct source_map {
+    char *text;
+    size_t size;
+    size_t map_size;
+} source_map_t;
+
+static bool source_map_open(source_map_t *map, const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        close(fd);
+        return false;
+    }
+    size_t file_size = (size_t)file_stat.st_size;
+    map->size = file_size;
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    map->map_size = (file_size + 1 + PARSE_PADDING + page_size - 1) / page_size * page_size;
+    map->text = mmap(NULL, map->map_size, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    bool mapped = map->text != MAP_FAILED;
+    if (mapped && file_size > 0) {
+        mapped = mmap(map->text, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0)
+            != MAP_FAILED;
+        if (mapped) {
+            madvise(map->text, file_size, MADV_SEQUENTIAL);
+        } else {
+            munmap(map->text, map->map_size);
+        }
+    }
+    close(fd);
+    return mapped;
+}
+
+static void source_map_close(source_map_t *map) {
+    munmap(map->text, map->map_size);
+}
+
+// Parallel Parsing
+// With --parse-threads N, a script of at least PARALLEL_PARSE_MIN bytes is
+// parsed by N threads while the main thread runs it. One pass over the text
+// follows the paren depth, stopping only at parens and newlines as the
+// streaming reader does, and cuts it into chunks of about PARALLEL_CHUNK_SIZE
+// bytes after a newline or a ')' where the depth is zero, so each top-level
+// form lies within one chunk. The threads take chunks in order and parse
+// each into its own array of forms; the main thread runs the arrays in
+// source order, waiting for a chunk only when it is not parsed yet. The
+// threads only parse: once a form has run it may hold compiled code and
+// expansions shared with the evaluator, so it is freed on the main thread
+// like any other. Parsing stays at most PARALLEL_CHUNKS_PER_THREAD chunks
+// per thread ahead, since parsed forms take many times the memory of their
+// text. Values are
+// allocated one by one with malloc as everywhere else, whose per-thread
+// arenas keep the threads apart; only the symbol table is shared, and
+// locked. Syntax errors are located in the whole file, and the first one
+// ends the forms, so the forms before it run just as when parsing
+// sequentially. A file that is one big form cannot be split, and
+// --hash-cons, whose table is not shared, parses on the main thread.
+#define PARALLEL_PARSE_MIN (1 << 20)
+#define PARALLEL_CHUNK_SIZE (256 << 10)
+#define PARALLEL_CHUNKS_PER_THREAD 2
+
+static int32_t parse_threads = 1;
+
+typedef struct parse_chunk {
+    char *start;
+    char *end;
+    work_stack_t forms; // pval *, in source order
+    pval *error;        // Syntax or memory error that ended the chunk
+    bool parsed;
+} parse_chunk_t;
+
+// Chunks before taken_chunk have run and been freed, and the ones from
+// next_chunk on are not parsed yet; lock guards both and the parsed flags.
+typedef struct parse_pool {
+    parse_chunk_t *chunks;
+    size_t chunk_count;
+    size_t next_chunk;
+    size_t taken_chunk;
+    size_t window;
+    bool stopping; // The script stopped early; the threads exit
+    const parse_source_t *source;
+    pthread_mutex_t lock;
+    pthread_cond_t chunk_parsed;
+    pthread_cond_t chunk_run;
+    pthread_t *threads;
+    int32_t thread_count;
+} parse_pool_t;
+
+// The forms of a script: parsed one at a time from parse_ptr, or taken in
+// order from the chunks of pool when it is not NULL. Forms taken are the
+// caller's to delete.
+typedef struct script_forms {
+    char *parse_ptr;
+    parse_source_t position;
+    parse_pool_t *pool;
+    int32_t next_form; // In chunk pool->taken_chunk
+    bool failed;
+} script_forms_t;
+
+// Cuts the size bytes at text into chunks of at least target bytes, except
+// the last, at top-level form boundaries. Returns the number of chunks.
+static size_t parse_split(char *text, size_t size, size_t target, parse_chunk_t *chunks,
+                          size_t chunk_limit) {
+    char *end = text + size;
+    char *at = text;
+    char *next_cut = text + target;
+    int64_t depth = 0;
+    size_t chunk_count = 0;
+    chunks[0].start = text;
+    while (chunk_count + 1 < chunk_limit) {
+        at += span_list_text(at);
+        if (at >= end || *at == '\0') {
+            break;
+        }
+        if (*at == '(') {
+            depth++;
+        } else if (*at == ')' && depth > 0) {
+            depth--;
+        }
+        at++;
+        if (depth == 0 && at >= next_cut && at[-1] != '(') {
+            chunks[chunk_count++].end = at;
+            chunks[chunk_count].start = at;
+            next_cut = at + target;
+        }
+    }
+    chunks[chunk_count++].end = end;
+    return chunk_count;
+}
+
+static void parse_chunk(parse_chunk_t *chunk, const parse_source_t *source) {
+    char *parse_ptr = chunk->start;
+    while (true) {
+        // A form that starts in the chunk also ends there, but past the last
+        // one pval_parse would go on into the next chunk.
+        skip_whitespace(&parse_ptr);
+        if (parse_ptr >= chunk->end) {
+            return;
+        }
+        pval *form = pval_parse(&parse_ptr, source);
+        if (form == NULL) {
+            return;
+        }
+        if (form->type == PVAL_ERROR) {
+            chunk->error = form;
+            return;
+        }
+        pval **slot = work_stack_push(&chunk->forms);
+        if (slot == NULL) {
+            pval_delete(form);
+            chunk->error = pval_error("MemoryError", "Failed to store parsed form");
+            return;
+        }
+        *slot = form;
+    }
+}
+
+static void parse_chunk_free(parse_chunk_t *chunk, int32_t first_form) {
+    pval **forms = (pval **)chunk->forms.items;
+    for (int32_t i = first_form; i < chunk->forms.count; i++) {
+        pval_delete(forms[i]);
+    }
+    work_stack_free(&chunk->forms);
+    pval_delete(chunk->error);
+}
+
+// Parses the next chunk whenever it is within the window, until every chunk
+// is parsed or the pool stops.
+static void *parse_worker(void *argument) {
+    parse_pool_t *pool = argument;
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stopping && pool->next_chunk < pool->chunk_count) {
+        if (pool->next_chunk < pool->taken_chunk + pool->window) {
+            parse_chunk_t *chunk = &pool->chunks[pool->next_chunk++];
+            pthread_mutex_unlock(&pool->lock);
+            parse_chunk(chunk, pool->source);
+            pthread_mutex_lock(&pool->lock);
+            chunk->parsed = true;
+            pthread_cond_broadcast(&pool->chunk_parsed);
+        } else {
+            pthread_cond_wait(&pool->chunk_run, &pool->lock);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+// Stops the threads and frees the forms that were not taken; next_form is
+// the first of them in chunk taken_chunk.
+static void parse_pool_free(parse_pool_t *pool, int32_t next_form) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = true;
+    pthread_cond_broadcast(&pool->chunk_run);
+    pthread_mutex_unlock(&pool->lock);
+    for (int32_t i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    symbol_table_shared = false;
+    // Chunks a thread never took are empty.
+    for (size_t i = pool->taken_chunk; i < pool->chunk_count; i++) {
+        parse_chunk_free(&pool->chunks[i], i == pool->taken_chunk ? next_form : 0);
+    }
+    pthread_cond_destroy(&pool->chunk_run);
+    pthread_cond_destroy(&pool->chunk_parsed);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->threads);
+    free(pool->chunks);
+    free(pool);
+}
+
+// Starts thread_count threads parsing the size bytes at text for forms.
+// Returns false, leaving forms to be parsed on this thread, if none start.
+static bool parse_parallel(char *text, size_t size, int32_t thread_count,
+                           script_forms_t *forms) {
+    size_t chunk_limit = size / PARALLEL_CHUNK_SIZE + 1;
+    parse_pool_t *pool = calloc(1, sizeof(parse_pool_t));
+    parse_chunk_t *chunks = malloc(chunk_limit * sizeof(parse_chunk_t));
+    pthread_t *threads = malloc((size_t)thread_count * sizeof(pthread_t));
+    if (pool == NULL || chunks == NULL || threads == NULL) {
+        free(pool);
+        free(chunks);
+        free(threads);
+        return false;
+    }
+    pool->chunks = chunks;
+    pool->chunk_count = parse_split(text, size, PARALLEL_CHUNK_SIZE, chunks, chunk_limit);
+    pool->window = (size_t)thread_count * PARALLEL_CHUNKS_PER_THREAD;
+    pool->source = &forms->position;
+    pool->threads = threads;
+    for (size_t i = 0; i < pool->chunk_count; i++) {
+        work_stack_init(&chunks[i].forms, sizeof(pval *));
+        chunks[i].error = NULL;
+        chunks[i].parsed = false;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->chunk_parsed, NULL);
+    pthread_cond_init(&pool->chunk_run, NULL);
+
+    symbol_table_shared = true;
+    while (pool->thread_count < thread_count
+           && pthread_create(&threads[pool->thread_count], NULL, parse_worker, pool) == 0) {
+        pool->thread_count++;
+    }
+    if (pool->thread_count == 0) {
+        parse_pool_free(pool, 0);
+        return false;
+    }
+    forms->pool = pool;
+    forms->next_form = 0;
+    return true;
+}
+
+static pval *script_next_form(script_forms_t *forms) {
+    parse_pool_t *pool = forms->pool;
+    if (pool == NULL) {
+        return pval_parse(&forms->parse_ptr, &forms->position);
+    }
+    // Nothing after the first error is taken.
+    while (!forms->failed && pool->taken_chunk < pool->chunk_count) {
+        parse_chunk_t *chunk = &pool->chunks[pool->taken_chunk];
+        pthread_mutex_lock(&pool->lock);
+        while (!chunk->parsed) {
+            pthread_cond_wait(&pool->chunk_parsed, &pool->lock);
+        }
+        pthread_mutex_unlock(&pool->lock);
+        if (forms->next_form < chunk->forms.count) {
+            return ((pval **)chunk->forms.items)[forms->next_form++];
+        }
+        if (chunk->error != NULL) {
+            pval *error = chunk->error;
+            chunk->error = NULL;
+            forms->failed = true;
+            return error;
+        }
+        parse_chunk_free(chunk, forms->next_form);
+        forms->next_form = 0;
+        pthread_mutex_lock(&pool->lock);
+        pool->taken_chunk++;
+        pthread_cond_broadcast(&pool->chunk_run);
+        pthread_mutex_unlock(&pool->lock);
+    }
+    return NULL;
+}
+
+static void script_forms_free(script_forms_t *forms) {
+    if (forms->pool != NULL) {
+        parse_pool_free(forms->pool, forms->next_form);
+    }
+}
+
+// Evaluates the forms of the file at path in order, printing each result as
+// the REPL does, without prompts. Returns false if the file cannot be read or
+// parsed; *quit is set once a form asks the interpreter to quit.
+static bool run_script(const char *path, bool *quit) {
+    source_map_t map;
+    if (!source_map_open(&map, path)) {
+        printf("$error{IOError Cannot read %s}\n", path);
+        return false;
+    }
+    script_forms_t forms = {map.text, {map.text, 1, 1}, NULL, 0, false};
+    if (parse_threads > 1 && !hash_cons_enabled && map.size >= PARALLEL_PARSE_MIN) {
+        parse_parallel(map.text, map.size, parse_threads, &forms);
+    }
+    bool parsed = true;
+    pval *parsed_value;
+    while (!*quit && (parsed_value = script_next_form(&forms)) != NULL) {
+        if (parsed_value->type == PVAL_ERROR) {
+            printf("$error{%s %s in %s}\n", parsed_value->error_type,
+                   parsed_value->error_message, path);
+            pval_delete(parsed_value);
+            parsed = false;
+            break;
+        }
+        pval *final_result = pval_eval(parsed_value);
+        pval_delete(parsed_value);
+        *quit = !report_result(final_result);
+    }
+    script_forms_free(&forms);
+    source_map_close(&map);
+    return parsed;
+}
+
+// Heap Images
+// --save-image writes every global binding to a file once the program or
+// REPL finishes, and --image loads such a file before anything runs. An
+// image is the magic "PSII", a version byte and the binding count, then for
+// each binding its name, a byte that is 1 for a macro, and the length and
+// bytes of its value in the serialized encoding, code included. The
+// encoding holds no addresses, so an image can be mapped anywhere. Loading
+// maps the file and reads only the names; each value stays in the mapping
+// until the first lookup of its name decodes it, so startup does not depend
+// on how much an image defines. Bindings to generators are left out.
+#define IMAGE_VERSION 1
+
+static const uint8_t image_magic[4] = {'P', 'S', 'I', 'I'};
+
+static source_map_t image_map; // Stays mapped while bindings refer to it
+
+static bool image_save(const char *path) {
+    serial_writer_t writer = {0};
+    serial_put(&writer, image_magic, sizeof(image_magic));
+    serial_put_tag(&writer, IMAGE_VERSION);
+    int32_t saved_count = 0;
+    size_t count_offset = writer.length;
+    serial_put(&writer, (uint8_t[5]){0}, 5); // Binding count, filled in below
+
+    for (int32_t i = 0; i < global_bucket_count; i++) {
+        for (global_binding_t *binding = global_buckets[i]; binding != NULL;
+             binding = binding->next) {
+            byte_string_t *encoded = NULL;
+            const uint8_t *data = binding->image_data;
+            size_t length = binding->image_length;
+            if (data == NULL) {
+                bool unsupported;
+                encoded = serialize_bytes(binding->value, true, &unsupported);
+                if (encoded == NULL) {
+                    fprintf(stderr, "$error{%s Cannot save %s in an image}\n",
+                            unsupported ? "TypeError" : "MemoryError", binding->name);
+                    continue;
+                }
+                data = encoded->data;
+                length = encoded->length;
+            }
+            serial_put_text(&writer, binding->name);
+            serial_put_tag(&writer, binding->macro);
+            serial_put_varint(&writer, length);
+            serial_put(&writer, data, length);
+            free(encoded);
+            saved_count++;
         }
-        running_sum += args[i]->number;
     }
-    return pval_number(running_sum);
-}
+    // A five byte varint, padded with continuation bits, so the size of the
+    // header does not depend on the count.
+    for (int32_t i = 0; !writer.failed && i < 5; i++) {
+        uint8_t byte = (uint8_t)(((uint32_t)saved_count >> (7 * i)) & 0x7F);
+        writer.data[count_offset + i] = i < 4 ? byte | 0x80 : byte;
+    }
 
-pval *builtin_sub(pval **args, int32_t arg_count) {
-    if (arg_count == 0) {
-        return pval_error("ArityError", "'-' requires at least one argument");
+    FILE *file = writer.failed ? NULL : fopen(path, "wb");
+    bool written = file != NULL && fwrite(writer.data, 1, writer.length, file) == writer.length;
+    if (file != NULL && fclose(file) != 0) {
+        written = false;
     }
-    if (args[0]->type != PVAL_NUMBER) {
-        return pval_error("TypeError", "First argument to - must be a number");
+    free(writer.data);
+    if (!written) {
+        fprintf(stderr, "$error{IOError Cannot write image %s}\n", path);
     }
+    return written;
+}
 
-    if (arg_count == 1) {
-        return pval_number(-args[0]->number);
-    } else if (arg_count == 2) {
-        if (args[1]->type != PVAL_NUMBER) {
-            return pval_error("TypeError", "Second argument to - must be a number");
+// Removes the bindings a failed load made, which still hold their values
+// undecoded, so that nothing refers to the mapping once it is closed.
+static void image_unbind(void) {
+    for (int32_t i = 0; i < global_bucket_count; i++) {
+        global_binding_t **link = &global_buckets[i];
+        while (*link != NULL) {
+            global_binding_t *binding = *link;
+            if (binding->image_data == NULL) {
+                link = &binding->next;
+                continue;
+            }
+            *link = binding->next;
+            if (binding->macro) {
+                global_macro_count--;
+                macro_generation++;
+            }
+            global_count--;
+            free(binding);
         }
-        return pval_number(args[0]->number - args[1]->number);
     }
-    return pval_error("ArityError", "'-' currently supports 1 or 2 arguments");
 }
 
-pval *builtin_mul(pval **args, int32_t arg_count) {
-    double running_product = 1.0;
-    if (arg_count == 0) {
-        return pval_number(1.0);
+static bool image_load(const char *path) {
+    if (!source_map_open(&image_map, path)) {
+        fprintf(stderr, "$error{IOError Cannot read image %s}\n", path);
+        return false;
     }
-
-    for (int32_t i = 0; i < arg_count; i++) {
-        if (args[i]->type != PVAL_NUMBER) {
-            return pval_error("TypeError", "Arguments to * must be numbers");
+    const uint8_t *data = (const uint8_t *)image_map.text;
+    if (image_map.size < sizeof(image_magic) + 1
+        || memcmp(data, image_magic, sizeof(image_magic)) != 0
+        || data[sizeof(image_magic)] != IMAGE_VERSION) {
+        fprintf(stderr, "$error{FormatError %s is not an image of this version}\n", path);
+        source_map_close(&image_map);
+        return false;
+    }
+    serial_reader_t reader = {
+        .next = data + sizeof(image_magic) + 1,
+        .end = data + image_map.size
+    };
+    uint64_t binding_count;
+    bool valid = serial_get_varint(&reader, &binding_count);
+    for (uint64_t i = 0; valid && i < binding_count; i++) {
+        uint64_t name_length, value_length;
+        valid = serial_get_varint(&reader, &name_length) && name_length > 0
+            && name_length < (uint64_t)(reader.end - reader.next);
+        if (!valid) {
+            break;
         }
-        running_product *= args[i]->number;
+        char *name = symbol_intern((const char *)reader.next, name_length);
+        reader.next += name_length;
+        uint8_t flags = *reader.next++;
+        valid = name != NULL && flags <= 1 && serial_get_varint(&reader, &value_length)
+            && value_length <= (uint64_t)(reader.end - reader.next)
+            && global_define(name, NULL, flags == 1);
+        if (!valid) {
+            break;
+        }
+        global_binding_t *binding = global_find(name);
+        binding->image_data = reader.next;
+        binding->image_length = value_length;
+        reader.next += value_length;
     }
-    return pval_number(running_product);
+    if (!valid || reader.next != reader.end) {
+        fprintf(stderr, "$error{FormatError Image %s is damaged}\n", path);
+        image_unbind();
+        source_map_close(&image_map);
+        return false;
+    }
+    return true;
 }
 
-pval *builtin_div(pval **args, int32_t arg_count) {
-    if (arg_count != 2) {
-        return pval_error("ArityError", "'/' requires exactly 2 arguments");
-    }
-    if (args[0]->type != PVAL_NUMBER || args[1]->type != PVAL_NUMBER) {
-        return pval_error("TypeError", "Arguments to / must be numbers");
+// C Code Emitter
+// --emit-c translates a program into C that links against this file: every
+// form is partially evaluated, then becomes a function building its values
+// with the pval constructors and calling the builtin_* functions through
+// pval_apply, so the compiled program does no parsing or symbol dispatch at
+// runtime. Global variables are read with pval_global, quote becomes the
+// datum, and if, cond, and and or become C conditionals over their emitted
+// operands. Other special forms that survive partial evaluation, such as
+// lambda expressions, are rebuilt as data and evaluated by pval_eval. The
+// output is built with
+//     cc -I<dir of main.c> -o program program.c
+// or, with -DPSI_NO_PROGRAM_MAIN -shared -fPIC, into a shared object exposing
+// psi_program_run().
+
+static const char *builtin_c_name(const char *name) {
+    for (int32_t i = 0; builtins[i].name != NULL; i++) {
+        if (strcmp(name, builtins[i].name) == 0) {
+            return builtins[i].c_name;
+        }
     }
-    if (args[1]->number == 0.0) {
-        return pval_error("DivisionByZeroError", "Division by zero");
+    return NULL;
+}
+
+static void emit_c_string(FILE *out, const char *str) {
+    fputc('"', out);
+    for (const char *c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(out, "\\%c", *c);
+        } else if (isprint((unsigned char)*c)) {
+            fputc(*c, out);
+        } else {
+            fprintf(out, "\\%03o", (unsigned char)*c);
+        }
     }
-    return pval_number(args[0]->number / args[1]->number);
+    fputc('"', out);
 }
 
-pval *builtin_eq(pval **args, int32_t arg_count) {
-    if (arg_count != 2) {
-        return pval_error("ArityError", "'=' requires exactly 2 arguments");
+// Blocks open around the statement being emitted.
+static int32_t emit_c_depth = 1;
+
+static void emit_c_indent(FILE *out) {
+    fprintf(out, "%*s", emit_c_depth * 4, "");
+}
+
+// Ends the if just written and opens its block.
+static void emit_c_open(FILE *out) {
+    fprintf(out, " {\n");
+    emit_c_depth++;
+}
+
+static void emit_c_else(FILE *out) {
+    emit_c_depth--;
+    emit_c_indent(out);
+    fprintf(out, "} else {\n");
+    emit_c_depth++;
+}
+
+static void emit_c_close(FILE *out, int32_t block_count) {
+    for (int32_t i = 0; i < block_count; i++) {
+        emit_c_depth--;
+        emit_c_indent(out);
+        fprintf(out, "}\n");
     }
+}
 
-    pval *first_arg = args[0];
-    pval *second_arg = args[1];
+// Emits the statements computing input_value into a fresh temporary and
+// returns that temporary's number.
+static int32_t emit_c_datum(FILE *out, pval *input_value, int32_t *next_temp);
+static int32_t emit_c_nested_expr(FILE *out, pval *input_value, int32_t *next_temp);
 
-    if (first_arg->type != second_arg->type) {
-        return pval_bool(false);
+static int32_t emit_c_expr(FILE *out, pval *input_value, int32_t *next_temp) {
+    if (!nesting_enter()) {
+        return -1;
     }
+    int32_t temp = emit_c_nested_expr(out, input_value, next_temp);
+    nesting_leave();
+    return temp;
+}
 
-    switch (first_arg->type) {
-    case PVAL_NUMBER:
-        return pval_bool(fabs(first_arg->number - second_arg->number) < 1e-10);
-    case PVAL_BOOL:
-        return pval_bool(first_arg->boolean == second_arg->boolean);
-    case PVAL_SYMBOL:
-        return pval_bool(strcmp(first_arg->symbol, second_arg->symbol) == 0);
-    default:
-        return pval_error("TypeError", "Unsupported types for equality comparison");
+// Emits expr and stores its value in the temporary result.
+static bool emit_c_assign(FILE *out, pval *expr, int32_t result, int32_t *next_temp) {
+    int32_t temp = emit_c_expr(out, expr, next_temp);
+    if (temp < 0) {
+        return false;
     }
+    emit_c_indent(out);
+    fprintf(out, "t%d = t%d;\n", result, temp);
+    return true;
 }
 
-pval *builtin_quit(pval **args, int32_t arg_count) {
-    if (arg_count != 0) {
-        return pval_error("ArityError", "quit takes no arguments");
+// Emits the condition test, deciding it into c<result> or leaving its error
+// in t<result>, and opens the block run when it was decided.
+static bool emit_c_condition(FILE *out, pval *test, int32_t result, int32_t *next_temp) {
+    int32_t temp = emit_c_expr(out, test, next_temp);
+    if (temp < 0) {
+        return false;
     }
-    return pval_symbol("quitting");
+    emit_c_indent(out);
+    fprintf(out, "t%d = pval_condition(t%d, &c%d);\n", result, temp, result);
+    emit_c_indent(out);
+    fprintf(out, "if (t%d == NULL)", result);
+    emit_c_open(out);
+    return true;
 }
 
-// Builtin Op Function Struct
-typedef struct builtin {
-    const char *name;
-    builtin_function_ptr func;
-} builtin_t;
+static bool emit_c_if(FILE *out, pval *form, int32_t result, int32_t *next_temp) {
+    if (!emit_c_condition(out, form->list_items[1], result, next_temp)) {
+        return false;
+    }
+    emit_c_indent(out);
+    fprintf(out, "if (c%d)", result);
+    emit_c_open(out);
+    bool emitted = emit_c_assign(out, form->list_items[2], result, next_temp);
+    emit_c_else(out);
+    if (form->list_count == 4) {
+        emitted = emitted && emit_c_assign(out, form->list_items[3], result, next_temp);
+    } else {
+        emit_c_indent(out);
+        fprintf(out, "t%d = pval_list();\n", result);
+    }
+    emit_c_close(out, 2);
+    return emitted;
+}
 
-builtin_t builtins[] = {
-    {"+", builtin_add},
-    {"-", builtin_sub},
-    {"*", builtin_mul},
-    {"/", builtin_div},
-    {"=", builtin_eq},
-    {"quit", builtin_quit},
-    {NULL, NULL}
-};
+// Runs the body of clause like special_cond: each item in turn until one is
+// an error, the last value being the result.
+static bool emit_c_clause_body(FILE *out, pval *clause, int32_t result, int32_t *next_temp) {
+    if (clause->list_count == 1) {
+        emit_c_indent(out);
+        fprintf(out, "t%d = pval_list();\n", result);
+        return true;
+    }
+    int32_t open_blocks = 0;
+    bool emitted = true;
+    for (int32_t k = 1; emitted && k < clause->list_count; k++) {
+        if (k > 1) {
+            emit_c_indent(out);
+            fprintf(out, "if (t%d != NULL && t%d->type != PVAL_ERROR)", result, result);
+            emit_c_open(out);
+            open_blocks++;
+            emit_c_indent(out);
+            fprintf(out, "pval_delete(t%d);\n", result);
+        }
+        emitted = emit_c_assign(out, clause->list_items[k], result, next_temp);
+    }
+    emit_c_close(out, open_blocks);
+    return emitted;
+}
 
-pval *pval_eval(pval *input_value) {
-    if (input_value == NULL) {
-        return NULL;
+// Each clause that does not match opens the block trying the next, so the
+// clauses nest instead of recursing in the emitter.
+static bool emit_c_cond(FILE *out, pval *form, int32_t result, int32_t *next_temp) {
+    int32_t open_blocks = 0;
+    bool emitted = true;
+    bool matched = false;
+    for (int32_t i = 1; emitted && !matched && i < form->list_count; i++) {
+        pval *clause = form->list_items[i];
+        pval *test = clause->list_items[0];
+        if (test->type == PVAL_SYMBOL && strcmp(test->symbol, "else") == 0) {
+            emitted = emit_c_clause_body(out, clause, result, next_temp);
+            matched = true;
+        } else if (clause->list_count == 1) {
+            // A clause without a body yields the test's own value.
+            int32_t temp = emit_c_expr(out, test, next_temp);
+            emitted = temp >= 0;
+            if (emitted) {
+                emit_c_indent(out);
+                fprintf(out, "if (t%d == NULL || t%d->type == PVAL_ERROR || pval_is_truthy(t%d))",
+                        temp, temp, temp);
+                emit_c_open(out);
+                emit_c_indent(out);
+                fprintf(out, "t%d = t%d;\n", result, temp);
+                emit_c_else(out);
+                emit_c_indent(out);
+                fprintf(out, "pval_delete(t%d);\n", temp);
+                open_blocks++;
+            }
+        } else {
+            emitted = emit_c_condition(out, test, result, next_temp);
+            if (emitted) {
+                emit_c_indent(out);
+                fprintf(out, "if (c%d)", result);
+                emit_c_open(out);
+                emitted = emit_c_clause_body(out, clause, result, next_temp);
+                emit_c_else(out);
+                open_blocks += 2;
+            }
+        }
+    }
+    if (emitted && !matched) {
+        emit_c_indent(out);
+        fprintf(out, "t%d = pval_list();\n", result);
     }
+    emit_c_close(out, open_blocks);
+    return emitted;
+}
 
-    if (input_value->type == PVAL_NUMBER || input_value->type == PVAL_BOOL
-        || input_value->type == PVAL_ERROR) {
-        if (input_value->type == PVAL_NUMBER) {
-            return pval_number(input_value->number);
+static bool emit_c_and(FILE *out, pval *form, int32_t result, int32_t *next_temp) {
+    if (form->list_count == 1) {
+        emit_c_indent(out);
+        fprintf(out, "t%d = pval_bool(true);\n", result);
+        return true;
+    }
+    int32_t open_blocks = 0;
+    bool emitted = true;
+    for (int32_t i = 1; emitted && i < form->list_count - 1; i++) {
+        emitted = emit_c_condition(out, form->list_items[i], result, next_temp);
+        if (emitted) {
+            emit_c_indent(out);
+            fprintf(out, "if (!c%d)", result);
+            emit_c_open(out);
+            emit_c_indent(out);
+            fprintf(out, "t%d = pval_bool(false);\n", result);
+            emit_c_else(out);
+            open_blocks += 2;
         }
-        if (input_value->type == PVAL_BOOL) {
-            return pval_bool(input_value->boolean);
+    }
+    emitted = emitted && emit_c_assign(out, form->list_items[form->list_count - 1], result,
+                                       next_temp);
+    emit_c_close(out, open_blocks);
+    return emitted;
+}
+
+static bool emit_c_or(FILE *out, pval *form, int32_t result, int32_t *next_temp) {
+    if (form->list_count == 1) {
+        emit_c_indent(out);
+        fprintf(out, "t%d = pval_bool(false);\n", result);
+        return true;
+    }
+    int32_t open_blocks = 0;
+    bool emitted = true;
+    for (int32_t i = 1; emitted && i < form->list_count - 1; i++) {
+        int32_t temp = emit_c_expr(out, form->list_items[i], next_temp);
+        emitted = temp >= 0;
+        if (emitted) {
+            emit_c_indent(out);
+            fprintf(out, "t%d = single_value(t%d);\n", result, temp);
+            emit_c_indent(out);
+            fprintf(out, "if (t%d != NULL && t%d->type != PVAL_ERROR && !pval_is_truthy(t%d))",
+                    result, result, result);
+            emit_c_open(out);
+            emit_c_indent(out);
+            fprintf(out, "pval_delete(t%d);\n", result);
+            open_blocks++;
         }
-        return pval_error(input_value->error_type, input_value->error_message);
     }
+    emitted = emitted && emit_c_assign(out, form->list_items[form->list_count - 1], result,
+                                       next_temp);
+    emit_c_close(out, open_blocks);
+    return emitted;
+}
 
-    if (input_value->type == PVAL_SYMBOL) {
-        for (int32_t i = 0; builtins[i].name != NULL; i++) {
-            if (strcmp(input_value->symbol, builtins[i].name) == 0) {
-                return pval_function(builtins[i].func);
+// Whether special form is one that emit_c_special_form translates: quote,
+// if, cond, and or or, well formed. The others, and malformed ones, are
+// left to pval_eval, which also reports their errors.
+static bool emit_c_translates(pval *form) {
+    const char *name = form->list_items[0]->symbol;
+    if (strcmp(name, "quote") == 0) {
+        return form->list_count == 2;
+    }
+    if (strcmp(name, "if") == 0) {
+        return form->list_count == 3 || form->list_count == 4;
+    }
+    if (strcmp(name, "cond") == 0) {
+        for (int32_t i = 1; i < form->list_count; i++) {
+            pval *clause = form->list_items[i];
+            if (clause->type != PVAL_LIST || clause->list_count == 0) {
+                return false;
             }
         }
-        return pval_error("UnboundError", "Symbol not bound to a function");
+        return true;
     }
+    return strcmp(name, "and") == 0 || strcmp(name, "or") == 0;
+}
 
-    if (input_value->type == PVAL_LIST) {
-        if (input_value->list_count < 0) {
-            return pval_error("ListError", "Invalid list count");
-        }
-        
-        if (input_value->list_count == 0) {
-            return pval_list();
+// Whether the emitted form decides a condition into a flag: an if, an and
+// with a test before its last operand, or a cond with a clause that has a
+// test and a body.
+static bool emit_c_decides(pval *form) {
+    const char *name = form->list_items[0]->symbol;
+    if (strcmp(name, "cond") == 0) {
+        for (int32_t i = 1; i < form->list_count; i++) {
+            pval *test = form->list_items[i]->list_items[0];
+            if (test->type == PVAL_SYMBOL && strcmp(test->symbol, "else") == 0) {
+                return false;
+            }
+            if (form->list_items[i]->list_count > 1) {
+                return true;
+            }
         }
+        return false;
+    }
+    return strcmp(name, "if") == 0 || (strcmp(name, "and") == 0 && form->list_count > 2);
+}
 
-        pval **evaluated_items = malloc(input_value->list_count * sizeof(pval *));
-        if (evaluated_items == NULL) {
-            return pval_error("MemoryError", "Failed to allocate evaluated items");
-        }
+static int32_t emit_c_special_form(FILE *out, pval *form, int32_t *next_temp) {
+    const char *name = form->list_items[0]->symbol;
+    if (strcmp(name, "quote") == 0) {
+        return emit_c_datum(out, form->list_items[1], next_temp);
+    }
+    int32_t result = (*next_temp)++;
+    emit_c_indent(out);
+    fprintf(out, "pval *t%d = NULL;\n", result);
+    if (emit_c_decides(form)) {
+        emit_c_indent(out);
+        fprintf(out, "bool c%d = false;\n", result);
+    }
+    bool emitted = strcmp(name, "if") == 0 ? emit_c_if(out, form, result, next_temp)
+        : strcmp(name, "cond") == 0 ? emit_c_cond(out, form, result, next_temp)
+        : strcmp(name, "and") == 0 ? emit_c_and(out, form, result, next_temp)
+        : emit_c_or(out, form, result, next_temp);
+    return emitted ? result : -1;
+}
 
+static int32_t emit_c_nested_expr(FILE *out, pval *input_value, int32_t *next_temp) {
+    if (is_special_form(input_value) && emit_c_translates(input_value)) {
+        return emit_c_special_form(out, input_value, next_temp);
+    }
+    if (is_special_form(input_value)) {
+        // Closures and definitions left after partial evaluation are
+        // evaluated at runtime from the rebuilt expression.
+        int32_t datum_temp = emit_c_datum(out, input_value, next_temp);
+        if (datum_temp < 0) {
+            return -1;
+        }
+        int32_t temp = (*next_temp)++;
+        emit_c_indent(out);
+        fprintf(out, "pval *t%d = pval_eval(t%d);\n", temp, datum_temp);
+        emit_c_indent(out);
+        fprintf(out, "pval_delete(t%d);\n", datum_temp);
+        return temp;
+    }
+    if (input_value->type == PVAL_LIST && input_value->list_count > 0) {
+        int32_t *item_temps = malloc(input_value->list_count * sizeof(int32_t));
+        if (item_temps == NULL) {
+            return -1;
+        }
         for (int32_t i = 0; i < input_value->list_count; i++) {
-            if (i >= input_value->list_count) {
-                for (int32_t k = 0; k < i; k++) {
-                    pval_delete(evaluated_items[k]);
-                }
-                free(evaluated_items);
-                return pval_error("ListError", "List index out of bounds");
-            }
-            evaluated_items[i] = pval_eval(input_value->list_items[i]);
-            if (evaluated_items[i] == NULL || evaluated_items[i]->type == PVAL_ERROR) {
-                pval *error_result = evaluated_items[i]
-                    ? pval_error(evaluated_items[i]->error_type,
-                                 evaluated_items[i]->error_message)
-                    : pval_error("EvalError", "Null evaluation result");
-                for (int32_t k = 0; k <= i; k++) {
-                    pval_delete(evaluated_items[k]);
-                }
-                free(evaluated_items);
-                return error_result;
+            item_temps[i] = emit_c_expr(out, input_value->list_items[i], next_temp);
+            if (item_temps[i] < 0) {
+                free(item_temps);
+                return -1;
             }
         }
+        int32_t temp = (*next_temp)++;
+        emit_c_indent(out);
+        fprintf(out, "pval *t%d = pval_apply((pval *[]){", temp);
+        for (int32_t i = 0; i < input_value->list_count; i++) {
+            fprintf(out, "%st%d", i > 0 ? ", " : "", item_temps[i]);
+        }
+        fprintf(out, "}, %d);\n", input_value->list_count);
+        free(item_temps);
+        return temp;
+    }
 
-        pval *function_head = evaluated_items[0];
-        if (function_head->type != PVAL_FUNCTION) {
-            pval *error_result = pval_error("InapplicableHeadError",
-                                            "Expression head is not a function");
-            for (int32_t i = 0; i < input_value->list_count; i++) {
-                pval_delete(evaluated_items[i]);
-            }
-            free(evaluated_items);
-            return error_result;
+    int32_t temp = (*next_temp)++;
+    emit_c_indent(out);
+    fprintf(out, "pval *t%d = ", temp);
+    switch (input_value->type) {
+    case PVAL_NUMBER:
+        if (isnan(input_value->number)) {
+            fprintf(out, "pval_number(NAN);\n");
+        } else if (isinf(input_value->number)) {
+            fprintf(out, "pval_number(%sHUGE_VAL);\n", input_value->number < 0 ? "-" : "");
+        } else {
+            fprintf(out, "pval_number(%a);\n", input_value->number);
         }
+        break;
+    case PVAL_BOOL:
+        fprintf(out, "pval_bool(%s);\n", input_value->boolean ? "true" : "false");
+        break;
+    case PVAL_SYMBOL:
+        if (builtin_c_name(input_value->symbol) != NULL) {
+            fprintf(out, "pval_function(%s);\n", builtin_c_name(input_value->symbol));
+        } else {
+            fprintf(out, "pval_global(");
+            emit_c_string(out, input_value->symbol);
+            fprintf(out, ");\n");
+        }
+        break;
+    case PVAL_LIST:
+        fprintf(out, "pval_list();\n");
+        break;
+    case PVAL_ERROR:
+        fprintf(out, "pval_error(");
+        emit_c_string(out, input_value->error_type);
+        fprintf(out, ", ");
+        emit_c_string(out, input_value->error_message);
+        fprintf(out, ");\n");
+        break;
+    case PVAL_FUNCTION:
+    case PVAL_CLOSURE:
+    case PVAL_PROMISE:
+    case PVAL_GENERATOR:
+    case PVAL_VALUES:
+    case PVAL_BYTES:
+        fprintf(out, "pval_error(\"EvalError\", \"Unsupported pval type for evaluation\");\n");
+        break;
+    }
+    return temp;
+}
 
-        pval **function_args = NULL;
-        int32_t num_args = input_value->list_count - 1;
-        if (num_args > 0) {
-            function_args = malloc(num_args * sizeof(pval *));
-            if (function_args == NULL) {
-                for (int32_t i = 0; i < input_value->list_count; i++) {
-                    pval_delete(evaluated_items[i]);
-                }
-                free(evaluated_items);
-                return pval_error("MemoryError",
-                                  "Failed to allocate arguments for function call");
-            }
-            for (int32_t i = 0; i < num_args; i++) {
-                if (i+1 >= input_value->list_count) {
-                    for (int32_t k = 0; k < input_value->list_count; k++) {
-                        pval_delete(evaluated_items[k]);
-                    }
-                    free(evaluated_items);
-                    free(function_args);
-                    return pval_error("ListError", "List index out of bounds");
-                }
-                function_args[i] = evaluated_items[i + 1];
-            }
+// Emits the statements rebuilding input_value as data, symbols included.
+static int32_t emit_c_datum(FILE *out, pval *input_value, int32_t *next_temp) {
+    if (input_value->type == PVAL_SYMBOL) {
+        int32_t temp = (*next_temp)++;
+        emit_c_indent(out);
+        fprintf(out, "pval *t%d = pval_symbol(", temp);
+        emit_c_string(out, input_value->symbol);
+        fprintf(out, ");\n");
+        return temp;
+    }
+    if (input_value->type != PVAL_LIST) {
+        return emit_c_expr(out, input_value, next_temp);
+    }
+    if (!nesting_enter()) {
+        return -1;
+    }
+    int32_t temp = (*next_temp)++;
+    emit_c_indent(out);
+    fprintf(out, "pval *t%d = pval_list();\n", temp);
+    for (int32_t i = 0; i < input_value->list_count && temp >= 0; i++) {
+        int32_t item_temp = emit_c_datum(out, input_value->list_items[i], next_temp);
+        if (item_temp < 0) {
+            temp = -1;
+        } else {
+            emit_c_indent(out);
+            fprintf(out, "pval_add(t%d, t%d);\n", temp, item_temp);
         }
+    }
+    nesting_leave();
+    return temp;
+}
 
-        pval *eval_result = function_head->function(function_args, num_args);
+static int32_t emit_c_program(const char *path) {
+    source_map_t map;
+    if (!source_map_open(&map, path)) {
+        fprintf(stderr, "$error{IOError Cannot read %s}\n", path);
+        return 1;
+    }
+    char *source = map.text;
 
-        pval_delete(function_head);
-        free(evaluated_items);
-        free(function_args);
+    FILE *out = stdout;
+    fprintf(out, "/* Generated by lisp_interpreter --emit-c from %s */\n", path);
+    fprintf(out, "#define PSI_NO_MAIN\n#include \"main.c\"\n\n");
 
-        return eval_result;
+    int32_t form_count = 0;
+    char *parse_ptr = source;
+    parse_source_t position = {source, 1, 1};
+    pval *parsed_value;
+    while ((parsed_value = pval_parse(&parse_ptr, &position)) != NULL) {
+        if (parsed_value->type == PVAL_ERROR) {
+            fprintf(stderr, "$error{%s %s}\n", parsed_value->error_type,
+                    parsed_value->error_message);
+            pval_delete(parsed_value);
+            source_map_close(&map);
+            return 1;
+        }
+        if (is_form_named(parsed_value, "defmacro")) {
+            // Defined at compile time as well, so later forms are emitted
+            // already expanded.
+            pval_delete(pval_eval(parsed_value));
+        }
+        pval *residual = pval_specialize(parsed_value);
+        pval_delete(parsed_value);
+        int32_t next_temp = 0;
+        fprintf(out, "static pval *psi_form_%d(void) {\n", form_count);
+        int32_t result_temp = residual ? emit_c_expr(out, residual, &next_temp) : -1;
+        pval_delete(residual);
+        if (result_temp < 0) {
+            fprintf(stderr, "$error{EmitError Form nested too deeply or out of memory}\n");
+            source_map_close(&map);
+            return 1;
+        }
+        fprintf(out, "    return t%d;\n}\n\n", result_temp);
+        form_count++;
     }
+    source_map_close(&map);
 
-    return pval_error("EvalError", "Unsupported pval type for evaluation");
+    fprintf(out, "static pval *(*const psi_forms[])(void) = {\n");
+    for (int32_t i = 0; i < form_count; i++) {
+        fprintf(out, "    psi_form_%d,\n", i);
+    }
+    fprintf(out, "    NULL\n};\n\n");
+    fprintf(out, "int psi_program_run(void) {\n"
+                 "    char base;\n"
+                 "    nesting_stack_init(&base);\n"
+                 "    for (int32_t i = 0; psi_forms[i] != NULL; i++) {\n"
+                 "        if (!report_result(psi_forms[i]())) {\n"
+                 "            break;\n"
+                 "        }\n"
+                 "    }\n"
+                 "    return 0;\n"
+                 "}\n\n"
+                 "#ifndef PSI_NO_PROGRAM_MAIN\n"
+                 "int main(void) {\n"
+                 "    return psi_program_run();\n"
+                 "}\n"
+                 "#endif\n");
+    return 0;
 }
 
-static bool check_balanced_parens(char *input_str, Stack *paren_stack) {
-    clear_stack(paren_stack);
-    for (char *i = input_str; *i != '\0'; i++) {
-        if (*i == '(') {
-            stack_insert(paren_stack, '(');
-        } else if (*i == ')') {
-            if (stack_is_empty(paren_stack)) {
-                clear_stack(paren_stack);
-                return false;
-            }
-            stack_pop(paren_stack);
+// Streaming Reader
+// The REPL pulls its input from a file descriptor in large blocks with
+// read(2) and splits it into top-level forms by tracking paren depth as the
+// bytes arrive, so a form may span any number of lines and have any length.
+// A form is handed out as soon as its last byte has been read; the reader
+// never waits for input past a complete form. The buffer grows to hold the
+// longest form and is compacted before each read.
+#define READER_BLOCK_SIZE 65536
+
+typedef struct reader {
+    int fd;
+    char *buffer;
+    size_t capacity;
+    size_t start;   // First byte of the form being read
+    size_t scanned; // End of the bytes already scanned for it
+    size_t end;     // End of the bytes read
+    int32_t depth;
+    int32_t line;   // Position of buffer[scanned] in the input
+    int32_t column;
+    int32_t form_line; // Position of the last form returned
+    int32_t form_column;
+    bool eof;
+    bool failed;
+    bool holding;   // buffer[start] was overwritten by the last form's '\0'
+    char held;
+} reader_t;
+
+static void reader_init(reader_t *reader, int fd) {
+    *reader = (reader_t){.fd = fd, .line = 1, .column = 1};
+}
+
+static void reader_free(reader_t *reader) {
+    free(reader->buffer);
+}
+
+// Reads the next block, first moving the unread bytes to the front and
+// growing the buffer when less than a block is free. Sets eof at the end of
+// the input or on an error.
+static void reader_fill(reader_t *reader) {
+    if (reader->start > 0) {
+        memmove(reader->buffer, reader->buffer + reader->start, reader->end - reader->start);
+        reader->scanned -= reader->start;
+        reader->end -= reader->start;
+        reader->start = 0;
+    }
+    size_t reserve = 1 + PARSE_PADDING; // For the '\0' after the input
+    if (reader->capacity - reader->end < READER_BLOCK_SIZE + reserve) {
+        size_t new_capacity = reader->capacity * 2;
+        if (new_capacity < reader->end + READER_BLOCK_SIZE + reserve) {
+            new_capacity = reader->end + READER_BLOCK_SIZE + reserve;
         }
+        char *grown = realloc(reader->buffer, new_capacity);
+        if (grown == NULL) {
+            reader->eof = reader->failed = true;
+            return;
+        }
+        reader->buffer = grown;
+        reader->capacity = new_capacity;
+    }
+    fflush(stdout); // Show the prompt before blocking
+    ssize_t bytes_read;
+    do {
+        bytes_read = read(reader->fd, reader->buffer + reader->end,
+                          reader->capacity - reader->end - reserve);
+    } while (bytes_read < 0 && errno == EINTR);
+    if (bytes_read > 0) {
+        reader->end += bytes_read;
+    } else {
+        reader->eof = true;
+        reader->failed = bytes_read < 0;
     }
-    bool balanced = stack_is_empty(paren_stack);
-    clear_stack(paren_stack);
-    return balanced;
+    reader->buffer[reader->end] = '\0';
 }
 
-int32_t main(void) {
-    Stack paren_stack;
-    stack_init(&paren_stack);
-
-    char input_buffer[1024] = {0};
+// Ends the current form at form_end and returns it, NUL-terminated in place.
+static char *reader_take(reader_t *reader, size_t form_end) {
+    char *form = reader->buffer + reader->start;
+    reader->holding = form_end < reader->end;
+    reader->held = reader->buffer[form_end];
+    reader->buffer[form_end] = '\0';
+    reader->start = reader->scanned = form_end;
+    return form;
+}
 
+// Returns the next top-level form, valid until the next call, or NULL at the
+// end of the input. A list still open at the end of the input is returned as
+// it is, and a ')' without a matching '(' is returned on its own, for the
+// parser to report. form_line and form_column locate the form in the input.
+static char *reader_next(reader_t *reader) {
+    if (reader->holding) {
+        reader->buffer[reader->start] = reader->held;
+        reader->holding = false;
+    }
     while (true) {
-        printf("psi> ");
-        if (fgets(input_buffer, sizeof(input_buffer), stdin) == NULL) {
-            if (feof(stdin)) {
-                printf("\nQuitting...\n");
-                break;
-            } else if (ferror(stdin)) {
-                printf("$error{IOError Input error}\n");
-                clearerr(stdin);
-                continue;
+        while (reader->scanned < reader->end) {
+            if (reader->depth > 0) {
+                // Inside a list only parens and line breaks need a look.
+                size_t plain = span_list_text(reader->buffer + reader->scanned);
+                reader->scanned += plain;
+                reader->column += (int32_t)plain;
+                if (reader->scanned == reader->end) {
+                    break;
+                }
+            }
+            char c = reader->buffer[reader->scanned];
+            bool at_form_start = reader->depth == 0 && reader->scanned == reader->start;
+            if (reader->depth == 0 && !at_form_start
+                && (isspace((unsigned char)c) || c == '(' || c == ')')) {
+                return reader_take(reader, reader->scanned); // End of an atom
+            }
+            if (at_form_start) {
+                reader->form_line = reader->line;
+                reader->form_column = reader->column;
+            }
+            reader->scanned++;
+            if (c == '\n') {
+                reader->line++;
+                reader->column = 1;
+            } else {
+                reader->column++;
+            }
+            if (at_form_start && isspace((unsigned char)c)) {
+                reader->start = reader->scanned; // Whitespace between forms
+            } else if (c == '(') {
+                reader->depth++;
+            } else if (c == ')') {
+                if (reader->depth > 0) {
+                    reader->depth--;
+                }
+                if (reader->depth == 0) {
+                    return reader_take(reader, reader->scanned);
+                }
             }
         }
-
-        if (strlen(input_buffer) == sizeof(input_buffer) - 1 && input_buffer[sizeof(input_buffer) - 2] != '\n') {
-            printf("$error{InputError Input exceeds maximum size of %zu bytes}\n", sizeof(input_buffer) - 1);
-            int c;
-            while ((c = getchar()) != '\n' && c != EOF);
-            memset(input_buffer, 0, sizeof(input_buffer));
-            continue;
+        if (reader->eof) {
+            reader->depth = 0;
+            return reader->scanned > reader->start ? reader_take(reader, reader->scanned) : NULL;
         }
+        reader_fill(reader);
+    }
+}
 
-        char *newline = strchr(input_buffer, '\n');
-        if (newline) *newline = '\0';
-
-        if (input_buffer[0] == '\0') {
-            printf("$error{SyntaxError Empty input}\n");
-            continue;
-        }
+// Reads forms from standard input until it ends or a form quits, printing
+// each result after a prompt.
+static void run_repl(void) {
+    reader_t reader;
+    reader_init(&reader, STDIN_FILENO);
 
-        if (!check_balanced_parens(input_buffer, &paren_stack)) {
-            printf("$error{SyntaxError Unbalanced parentheses}\n");
-            continue;
+    while (true) {
+        printf("psi> ");
+        char *form = reader_next(&reader);
+        if (form == NULL) {
+            if (reader.failed) {
+                printf("$error{IOError Input error}");
+            }
+            printf("\nQuitting...\n");
+            break;
         }
 
-        char *parse_ptr = input_buffer;
-        pval *parsed_value = pval_parse(&parse_ptr);
+        char *parse_ptr = form;
+        parse_source_t position = {form, reader.form_line, reader.form_column};
+        pval *parsed_value = pval_parse(&parse_ptr, &position);
 
         if (parsed_value == NULL) {
             printf("$error{SyntaxError Empty input or unparsable}\n");
@@ -671,23 +7078,70 @@ int32_t main(void) {
         pval *final_result = pval_eval(parsed_value);
         pval_delete(parsed_value);
 
-        if (final_result != NULL) {
-            if (final_result->type == PVAL_SYMBOL && 
-                strcmp(final_result->symbol, "quitting") == 0) {
-                printf("Quitting...\n");
-                pval_delete(final_result);
-                break;
-            }
-            
-            pval_print(final_result);
-            printf("\n");
-            pval_delete(final_result);
+        if (!report_result(final_result)) {
+            break;
+        }
+    }
+    reader_free(&reader);
+}
+
+int32_t main(int argc, char **argv) {
+    if (argc == 3 && strcmp(argv[1], "--emit-c") == 0) {
+        nesting_stack_init((char *)&argc); // defmacro is evaluated while emitting
+        return emit_c_program(argv[2]);
+    }
+    char **scripts = argv + 1; // Moved to the front as the flags are consumed
+    int32_t script_count = 0;
+    const char *image_path = NULL;
+    const char *save_image_path = NULL;
+    for (int32_t i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--profile") == 0) {
+            profile_enabled = true;
+        } else if (strcmp(argv[i], "--hash-cons") == 0) {
+            hash_cons_enabled = true;
+        } else if (strcmp(argv[i], "--max-depth") == 0 && i + 1 < argc
+                   && atoi(argv[i + 1]) > 0) {
+            max_nesting_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            image_path = argv[++i];
+        } else if (strcmp(argv[i], "--save-image") == 0 && i + 1 < argc) {
+            save_image_path = argv[++i];
+        } else if (strcmp(argv[i], "--parse-threads") == 0 && i + 1 < argc
+                   && atoi(argv[i + 1]) > 0) {
+            parse_threads = atoi(argv[++i]);
+        } else if (argv[i][0] != '-') {
+            scripts[script_count++] = argv[i];
         } else {
-            printf("$error{EvalError Null result from evaluation}\n");
+            fprintf(stderr, "usage: %s [--profile] [--hash-cons] [--max-depth N] [--image in.img]"
+                    " [--save-image out.img] [--parse-threads N]"
+                    " [file.lisp...] | --emit-c file.lisp\n", argv[0]);
+            return 1;
         }
+    }
 
-        memset(input_buffer, 0, sizeof(input_buffer));
+    nesting_stack_init((char *)&argc);
+    if (image_path != NULL && !image_load(image_path)) {
+        return 1;
+    }
+    int32_t status = 0;
+    if (script_count > 0) {
+        bool quit = false;
+        for (int32_t i = 0; i < script_count && !quit; i++) {
+            if (!run_script(scripts[i], &quit)) {
+                status = 1;
+                break;
+            }
+        }
+    } else {
+        run_repl();
+    }
+    if (status == 0 && save_image_path != NULL && !image_save(save_image_path)) {
+        status = 1;
     }
 
-    return 0;
-}
\ No newline at end of file
+    if (profile_enabled) {
+        profile_report(stderr);
+    }
+    return status;
+}
+#endif /* PSI_NO_MAIN */